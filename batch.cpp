@@ -0,0 +1,144 @@
+#include "batch.h"
+#include "qdimacs.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+BatchRunner::BatchRunner(int num_workers, const QBFSolver::Options& options)
+    : num_workers(std::max(1, num_workers)), options(options) {
+    // 平行度來自 worker 本身，子問題不再另開 thread
+    this->options.component_threads = 1;
+}
+
+void BatchRunner::readJobs(std::istream& in, std::vector<Job>& jobs) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string first, second;
+        if (!(ss >> first) || first[0] == '#') continue;
+        Job job;
+        if (ss >> second) {
+            job.id = first;
+            job.path = second;
+        } else {
+            job.id = first;
+            job.path = first;
+        }
+        jobs.push_back(job);
+    }
+}
+
+BatchRunner::Result BatchRunner::solveOne(Worker& worker, const Job& job) {
+    Result r;
+    auto start = std::chrono::steady_clock::now();
+    // parseQDIMACS 會先清空 prefix 與 matrix，保留已配置的容量。
+    // 一個檔案出錯 (例如記憶體不足) 只讓這個工作變成 ERROR，不影響其他工作
+    try {
+        if (!parseQDIMACS(job.path.c_str(), worker.prefix, worker.matrix, worker.error)) {
+            r.error = true;
+            r.message = "parse error: " + worker.error;
+        } else {
+            r.result = worker.solver.solve(worker.prefix, worker.matrix);
+        }
+    } catch (const std::exception& e) {
+        r.error = true;
+        r.message = std::string("exception: ") + e.what();
+        // 失敗的工作可能留下很大的緩衝區，不再保留
+        worker.prefix = {};
+        worker.matrix = ClauseDB();
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.done = true;
+    return r;
+}
+
+void BatchRunner::writeLine(std::ostream& os, const Job& job, const Result& result) {
+    const char* text = result.error ? "ERROR"
+                     : result.result == Q_SAT ? "SAT"
+                     : result.result == Q_UNSAT ? "UNSAT" : "UNKNOWN";
+    os << job.id << " " << text << " " << std::fixed << std::setprecision(4) << result.seconds << "\n";
+}
+
+void BatchRunner::run(const std::vector<Job>& jobs, std::ostream& os, bool ordered) {
+    auto start = std::chrono::steady_clock::now();
+    int num_jobs = jobs.size();
+    int n = std::min(num_workers, std::max(1, num_jobs));
+
+    // 1. 每個 worker 一個佇列，工作以 round-robin 分配：
+    //    依序輸出時，前面的工作會最先被各 worker 拿到
+    std::vector<std::deque<int>> queues(n);
+    std::vector<std::mutex> queue_mutex(n);
+    for (int i = 0; i < num_jobs; i++) queues[i % n].push_back(i);
+
+    auto takeJob = [&](int self) {
+        // 自己的佇列從前端拿
+        {
+            std::lock_guard<std::mutex> guard(queue_mutex[self]);
+            if (!queues[self].empty()) {
+                int job = queues[self].front();
+                queues[self].pop_front();
+                return job;
+            }
+        }
+        // 空了就從其他 worker 的尾端偷一個
+        for (int k = 1; k < n; k++) {
+            int victim = (self + k) % n;
+            std::lock_guard<std::mutex> guard(queue_mutex[victim]);
+            if (!queues[victim].empty()) {
+                int job = queues[victim].back();
+                queues[victim].pop_back();
+                return job;
+            }
+        }
+        return -1;
+    };
+
+    // 2. 結果：ordered 時只輸出從 next_output 開始連續完成的部分
+    std::vector<Result> results(num_jobs);
+    std::mutex output_mutex;
+    int next_output = 0;
+    num_solved = 0;
+    num_errors = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int w = 0; w < n; w++) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->solver.options = options;
+    }
+
+    auto work = [&](int self) {
+        Worker& worker = *workers[self];
+        for (int job = takeJob(self); job >= 0; job = takeJob(self)) {
+            Result r = solveOne(worker, jobs[job]);
+            std::lock_guard<std::mutex> guard(output_mutex);
+            results[job] = r;
+            if (r.error) {
+                num_errors++;
+                std::cerr << jobs[job].id << ": " << r.message << std::endl;
+            } else if (r.result != Q_UNKNOWN) num_solved++;
+            if (!ordered) {
+                writeLine(os, jobs[job], r);
+                continue;
+            }
+            while (next_output < num_jobs && results[next_output].done) {
+                writeLine(os, jobs[next_output], results[next_output]);
+                next_output++;
+            }
+        }
+        std::lock_guard<std::mutex> guard(output_mutex);
+        os.flush();
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < n; w++) threads.emplace_back(work, w);
+    work(0);
+    for (auto& thread : threads) thread.join();
+
+    wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,62 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Batch 模式：在同一個行程中以固定數量的 worker thread 求解大量 QDIMACS 檔案。
+// 工作以 round-robin 分給各 worker 的佇列，自己的佇列空了就從其他 worker 的尾端偷 (work stealing)。
+// 每個 worker 在工作之間重複使用自己的 QBFSolver、prefix 與 ClauseDB，不必每次重新配置。
+class BatchRunner {
+public:
+    struct Job {
+        std::string id;   // 輸出時的標籤，未指定時為檔名
+        std::string path;
+    };
+
+    BatchRunner(int num_workers, const QBFSolver::Options& options);
+
+    // 每行一個工作："path" 或 "id path"；空行與 '#' 開頭的註解略過
+    static void readJobs(std::istream& in, std::vector<Job>& jobs);
+
+    // 每個工作輸出一行 "id SAT|UNSAT|UNKNOWN|ERROR seconds"；ERROR 的原因以 "id: 原因" 寫到 stderr。
+    // ordered 為 true 時依輸入順序輸出 (先完成的會等待前面的工作)，否則完成一個就輸出一個
+    void run(const std::vector<Job>& jobs, std::ostream& os, bool ordered);
+
+    // 最近一次 run 的彙總
+    int solved() const { return num_solved; }
+    int errors() const { return num_errors; }
+    double seconds() const { return wall_seconds; }
+
+private:
+    // 一個 worker 在工作之間保留的狀態
+    struct Worker {
+        QBFSolver solver;
+        std::vector<QBFSolver::Formula> prefix;
+        ClauseDB matrix;
+        std::string error;
+    };
+
+    struct Result {
+        QBFResult result = Q_UNKNOWN;
+        bool error = false;
+        std::string message; // error 時的原因，輸出到 stderr
+        bool done = false;
+        double seconds = 0;
+    };
+
+    int num_workers;
+    QBFSolver::Options options;
+    int num_solved = 0;
+    int num_errors = 0;
+    double wall_seconds = 0;
+
+    Result solveOne(Worker& worker, const Job& job);
+    static void writeLine(std::ostream& os, const Job& job, const Result& result);
+};
+
+#endif
@@ -0,0 +1,338 @@
+// Benchmark runner：對每個 QDIMACS 檔案呼叫 QBFSolver::solve，
+// 回報 wall time、CEGAR 迭代次數與最大 RSS，並與 baseline 比較。
+//
+//   bench_runner [--baseline FILE] [--update] [--timeout SEC] [--slowdown X] files...
+//   bench_runner --incremental [--timeout SEC] files...
+//   bench_runner --budget SEC [--timeout SEC]
+//
+// 每個檔案在自己的子行程中求解 (fork)，RSS 由 wait4 的 ru_maxrss 取得，
+// 逾時以 SIGALRM 結束子行程。--update 時把本次結果寫成新的 baseline。
+// baseline 每行：name result seconds iterations rss_kb
+// 任何結果與 baseline 不同 (SAT / UNSAT) 時回傳 1。
+//
+// --incremental 檢查增量介面，不比較 baseline：公式的前一半以 load 載入，其餘子句分批 addClause，
+// 每批之後以隨機的最外層 assumption 呼叫 solveAssuming，並與代入 assumption 後重新 solve 的結果比較。
+// 增量模式不做前處理，有些檔案會很難：每次查詢最多 0.2 秒，任一邊 UNKNOWN 時不比較。
+// 結果欄為 OK 或 MISMATCH，iters 欄為實際比較的次數；有 MISMATCH 時回傳 1。
+//
+// --budget 檢查 time_limit 是 wall-clock：兩個 thread 同時求解很難的鴿籠公式 (一律使用 CMS)，
+// 上限都是 SEC 秒。兩個都要回傳 UNKNOWN，且花的時間在 [0.9 SEC, SEC + 0.5] 之內，否則回傳 1。
+// (上限若以整個行程的 CPU 時間計算，兩個 thread 會用掉彼此的時間而提早停下。)
+#include "../qbf.h"
+#include "../qdimacs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Record {
+    std::string result;  // SAT / UNSAT / TIMEOUT / ERROR
+    double seconds = 0;
+    long long iterations = 0;
+    long rss_kb = 0;
+};
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+std::map<std::string, Record> readBaseline(const char* path) {
+    std::map<std::string, Record> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        std::string name;
+        Record r;
+        if (ss >> name >> r.result >> r.seconds >> r.iterations >> r.rss_kb) baseline[name] = r;
+    }
+    return baseline;
+}
+
+// matrix 的前 num_clauses 個子句，代入 assumptions (最外層的文字) 後的公式
+void substitute(const ClauseDB& matrix, size_t num_clauses, const std::vector<int>& assumptions, ClauseDB& out) {
+    std::vector<signed char> value(matrix.maxVar() + 1, 0);
+    for (int lit : assumptions) value[std::abs(lit)] = (lit > 0) ? 1 : -1;
+    out.clear();
+    std::vector<int> clause;
+    for (size_t i = 0; i < num_clauses; i++) {
+        clause.clear();
+        bool satisfied = false;
+        for (int lit : matrix[i]) {
+            int v = value[std::abs(lit)];
+            if (v == 0) clause.push_back(lit);
+            else if ((v > 0) == (lit > 0)) satisfied = true;
+        }
+        if (!satisfied) out.addClause(clause);
+    }
+}
+
+// --incremental 的子行程本體：回傳不一致的次數，實際比較的次數寫進 checks
+int checkIncremental(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix, long long& checks) {
+    checks = 0;
+    if (prefix.empty()) return 0;
+    std::mt19937 rng(1);
+    size_t loaded = matrix.size() / 2;
+    ClauseDB first;
+    for (size_t i = 0; i < loaded; i++) first.addClause(std::vector<int>(matrix[i].begin(), matrix[i].end()));
+
+    const double query_seconds = 0.2;
+    QBFSolver inc;
+    inc.options.time_limit = query_seconds;
+    inc.load(prefix, first);
+    // 最多比較約 8 批，每批之後兩次查詢：隨機 assumption 與沒有 assumption
+    size_t step = std::max<size_t>(1, (matrix.size() - loaded) / 8);
+    int mismatches = 0;
+    std::vector<int> assumptions;
+    ClauseDB fixed;
+    for (size_t k = loaded;; k = std::min(matrix.size(), k + step)) {
+        for (int query = 0; query < 2; query++) {
+            assumptions.clear();
+            if (query == 0) {
+                for (int v : prefix[0].vars) {
+                    if (rng() % 3 == 0) assumptions.push_back(rng() % 2 ? v : -v);
+                }
+            }
+            QBFResult got = inc.solveAssuming(assumptions);
+            substitute(matrix, k, assumptions, fixed);
+            std::vector<QBFSolver::Formula> fresh_prefix = prefix;
+            QBFSolver fresh;
+            fresh.options.time_limit = query_seconds;
+            QBFResult expected = fresh.solve(fresh_prefix, fixed);
+            if (got == Q_UNKNOWN || expected == Q_UNKNOWN) continue;
+            checks++;
+            if (got != expected) mismatches++;
+        }
+        if (k >= matrix.size()) break;
+        for (size_t i = k; i < std::min(matrix.size(), k + step); i++) {
+            if (!inc.addClause(std::vector<int>(matrix[i].begin(), matrix[i].end()))) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// n + 1 隻鴿子放進 n 個洞，每個洞最多一隻 (UNSAT)；變數 p(i, j) = i * n + j + 1
+void pigeonhole(int n, std::vector<QBFSolver::Formula>& prefix, ClauseDB& matrix) {
+    prefix.assign(1, QBFSolver::Formula{'e', {}});
+    matrix.clear();
+    for (int v = 1; v <= (n + 1) * n; v++) prefix[0].vars.push_back(v);
+    std::vector<int> clause;
+    for (int i = 0; i <= n; i++) {
+        clause.clear();
+        for (int j = 0; j < n; j++) clause.push_back(i * n + j + 1);
+        matrix.addClause(clause);
+    }
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i <= n; i++) {
+            for (int k = i + 1; k <= n; k++) matrix.addClause(std::vector<int>{-(i * n + j + 1), -(k * n + j + 1)});
+        }
+    }
+}
+
+// --budget 的本體：回傳超出範圍 (或沒有回傳 UNKNOWN) 的 thread 數
+int checkBudget(double budget) {
+    const int num_threads = 2;
+    std::vector<QBFResult> results(num_threads, Q_UNKNOWN);
+    std::vector<double> seconds(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<QBFSolver::Formula> prefix;
+            ClauseDB matrix;
+            pigeonhole(12, prefix, matrix);
+            QBFSolver solver;
+            solver.options.small_sat_vars = 0;
+            solver.options.time_limit = budget;
+            auto start = std::chrono::steady_clock::now();
+            results[t] = solver.solve(prefix, matrix);
+            seconds[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    for (std::thread& th : threads) th.join();
+
+    int failures = 0;
+    for (int t = 0; t < num_threads; t++) {
+        bool ok = results[t] == Q_UNKNOWN && seconds[t] >= 0.9 * budget && seconds[t] <= budget + 0.5;
+        if (!ok) failures++;
+        std::cout << "thread " << t << std::right << std::setw(10)
+                  << (results[t] == Q_SAT ? "SAT" : results[t] == Q_UNSAT ? "UNSAT" : "UNKNOWN")
+                  << std::setw(11) << std::fixed << std::setprecision(4) << seconds[t] << (ok ? "" : "  OUT OF RANGE") << std::endl;
+    }
+    std::cout << "budget " << budget << " s, " << failures << " failures" << std::endl;
+    return failures;
+}
+
+// 子行程：求解並把 "result seconds iterations" 寫進 pipe
+[[noreturn]] void runChild(const char* path, int fd, int timeout, bool incremental) {
+    // solver 的 log 不混進報表
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) dup2(devnull, STDOUT_FILENO);
+    alarm(timeout);
+
+    std::vector<QBFSolver::Formula> prefix;
+    ClauseDB matrix;
+    std::string error;
+    std::string out = "ERROR 0 0";
+    bool parsed = parseQDIMACS(path, prefix, matrix, error);
+    if (parsed && incremental) {
+        auto start = std::chrono::steady_clock::now();
+        long long checks = 0;
+        int mismatches = checkIncremental(prefix, matrix, checks);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::ostringstream ss;
+        ss << (mismatches > 0 ? "MISMATCH" : "OK") << " " << seconds << " " << checks;
+        out = ss.str();
+    } else if (parsed) {
+        QBFSolver solver;
+        QBFResult res = solver.solve(prefix, matrix);
+        const QBFSolver::Stats& st = solver.stats();
+        long long iterations = 0;
+        for (const auto& ls : st.levels) iterations += ls.iterations;
+        std::ostringstream ss;
+        ss << (res == Q_SAT ? "SAT" : res == Q_UNSAT ? "UNSAT" : "UNKNOWN") << " " << st.seconds << " " << iterations;
+        out = ss.str();
+    }
+    if (write(fd, out.c_str(), out.size()) < 0) _exit(2);
+    _exit(0);
+}
+
+Record runOne(const char* path, int timeout, bool incremental) {
+    Record r;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        r.result = "ERROR";
+        return r;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        runChild(path, fds[1], timeout, incremental);
+    }
+    close(fds[1]);
+
+    std::string text;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) text.append(buf, n);
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    r.rss_kb = usage.ru_maxrss;
+
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+        r.result = "TIMEOUT";
+        r.seconds = timeout;
+        return r;
+    }
+    std::istringstream ss(text);
+    if (!(ss >> r.result >> r.seconds >> r.iterations)) r.result = "ERROR";
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* baseline_path = nullptr;
+    bool update = false;
+    bool incremental = false;
+    double budget = 0;
+    int timeout = 60;
+    double slowdown = 1.5; // 比 baseline 慢超過此倍數時標記
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baseline_path = argv[++i];
+        else if (std::strcmp(argv[i], "--update") == 0) update = true;
+        else if (std::strcmp(argv[i], "--incremental") == 0) incremental = true;
+        else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc) budget = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) timeout = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--slowdown") == 0 && i + 1 < argc) slowdown = std::atof(argv[++i]);
+        else files.push_back(argv[i]);
+    }
+    if (budget > 0) {
+        alarm(timeout);
+        return checkBudget(budget) > 0 ? 1 : 0;
+    }
+    if (files.empty()) {
+        std::cerr << "usage: bench_runner [--baseline FILE] [--update] [--timeout SEC] [--slowdown X] files..." << std::endl
+                  << "       bench_runner --incremental [--timeout SEC] files..." << std::endl
+                  << "       bench_runner --budget SEC [--timeout SEC]" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, Record> baseline;
+    if (incremental) {
+        baseline_path = nullptr;
+        update = false;
+    }
+    if (baseline_path != nullptr && !update) baseline = readBaseline(baseline_path);
+
+    std::cout << std::left << std::setw(34) << "instance" << std::right
+              << std::setw(8) << "result" << std::setw(11) << "seconds" << std::setw(11) << "iters"
+              << std::setw(10) << "rss_kb" << std::setw(11) << "base_s" << std::setw(9) << "ratio" << std::endl;
+
+    std::vector<std::pair<std::string, Record>> records;
+    int mismatches = 0, slower = 0;
+    double total = 0, base_total = 0;
+    for (const char* path : files) {
+        std::string name = baseName(path);
+        Record r = runOne(path, timeout, incremental);
+        records.push_back({name, r});
+        total += r.seconds;
+
+        std::cout << std::left << std::setw(34) << name << std::right
+                  << std::setw(8) << r.result << std::setw(11) << std::fixed << std::setprecision(4) << r.seconds
+                  << std::setw(11) << r.iterations << std::setw(10) << r.rss_kb;
+        if (r.result == "MISMATCH") mismatches++;
+        auto it = baseline.find(name);
+        if (it != baseline.end()) {
+            const Record& b = it->second;
+            base_total += b.seconds;
+            double ratio = (b.seconds > 0) ? r.seconds / b.seconds : 0;
+            std::cout << std::setw(11) << b.seconds << std::setw(9) << std::setprecision(2) << ratio;
+            // 太短的執行時間只是雜訊，不比較快慢
+            if (b.seconds >= 0.05 && ratio > slowdown) {
+                std::cout << "  SLOWER";
+                slower++;
+            }
+            if (b.result != r.result && b.result != "TIMEOUT" && r.result != "TIMEOUT") {
+                std::cout << "  MISMATCH (baseline " << b.result << ")";
+                mismatches++;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "total " << std::fixed << std::setprecision(3) << total << " s";
+    if (base_total > 0) std::cout << " (baseline " << base_total << " s)";
+    std::cout << ", " << slower << " slower, " << mismatches << " mismatches" << std::endl;
+
+    if (update && baseline_path != nullptr) {
+        std::ofstream out(baseline_path);
+        out << "# name result seconds iterations rss_kb\n";
+        for (const auto& [name, r] : records) {
+            out << name << " " << r.result << " " << r.seconds << " " << r.iterations << " " << r.rss_kb << "\n";
+        }
+        std::cout << "baseline written to " << baseline_path << std::endl;
+    }
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+// 隨機 / 結構化 QBF 產生器，輸出 QDIMACS 到 stdout
+//
+//   gen_qbf random  [--vars N] [--depth D] [--first e|a] [--blocks n1,n2,...]
+//                   [--ratio R] [--width K] [--xor-density P] [--seed S]
+//   gen_qbf parity  [--vars N] [--unsat]
+//   gen_qbf equal   [--vars N] [--unsat]
+//
+// random : D 個交錯的量詞區塊 (預設平均分配，或以 --blocks 指定各區塊大小)，
+//          R*N 個長度 K 的子句，每個子句至少含兩個 ∃ 文字；
+//          其中比例 P 的限制改為 3 個變數的 XOR (同一個 ∃ 區塊內，以 4 個子句編碼)。
+// parity : ∀x1..xn ∃t1..tn，t1 = x1，ti = t(i-1) XOR xi；--unsat 時再加上單位子句 tn
+//          (∀ 可以讓 parity 為偶數)。測試 XOR 還原與 Gauss-Jordan。
+// equal  : ∀x ∃y，yi <-> xi (SAT)；--unsat 時量詞順序相反，∃y ∀x (UNSAT)。
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Params {
+    std::string family = "random";
+    int vars = 30;
+    int depth = 3;
+    char first = 'e';
+    std::vector<int> blocks;
+    double ratio = 3.0;
+    int width = 3;
+    double xor_density = 0.0;
+    unsigned seed = 1;
+    bool unsat = false;
+};
+
+struct Formula {
+    std::vector<std::pair<char, std::vector<int>>> prefix;
+    std::vector<std::vector<int>> clauses;
+    int num_vars = 0;
+};
+
+void usage() {
+    std::cerr << "usage: gen_qbf random|parity|equal [--vars N] [--depth D] [--first e|a]" << std::endl
+              << "               [--blocks n1,n2,...] [--ratio R] [--width K]" << std::endl
+              << "               [--xor-density P] [--seed S] [--unsat]" << std::endl;
+}
+
+// 3 個變數的 XOR = rhs：禁止所有 parity 不符的賦值
+void addXor(Formula& f, int a, int b, int c, bool rhs) {
+    int vars[3] = {a, b, c};
+    for (int signs = 0; signs < 8; signs++) {
+        // 子句排除的賦值：第 j 個變數為 ((signs >> j) & 1)
+        int ones = __builtin_popcount(signs);
+        if ((ones & 1) == (int)rhs) continue;
+        std::vector<int> clause;
+        for (int j = 0; j < 3; j++) clause.push_back(((signs >> j) & 1) ? -vars[j] : vars[j]);
+        f.clauses.push_back(clause);
+    }
+}
+
+Formula genRandom(const Params& p) {
+    Formula f;
+    std::mt19937 rng(p.seed);
+    f.num_vars = p.vars;
+
+    // 1. 區塊大小
+    std::vector<int> sizes = p.blocks;
+    if (sizes.empty()) {
+        int depth = std::max(1, std::min(p.depth, p.vars));
+        for (int d = 0; d < depth; d++) sizes.push_back(p.vars / depth + (d < p.vars % depth ? 1 : 0));
+    }
+    int var = 1;
+    char q = p.first;
+    std::vector<int> existentials;
+    std::vector<std::vector<int>> e_blocks;
+    for (int size : sizes) {
+        std::vector<int> block;
+        for (int i = 0; i < size && var <= p.vars; i++) block.push_back(var++);
+        if (q == 'e') {
+            existentials.insert(existentials.end(), block.begin(), block.end());
+            e_blocks.push_back(block);
+        }
+        f.prefix.push_back({q, block});
+        q = (q == 'e') ? 'a' : 'e';
+    }
+    f.num_vars = var - 1;
+    if (existentials.empty() || f.num_vars == 0) return f;
+
+    // 2. 限制：一部分為 XOR，其餘為隨機子句
+    int constraints = (int)(p.ratio * f.num_vars + 0.5);
+    int num_xors = (int)(p.xor_density * constraints + 0.5);
+    std::vector<std::vector<int>> xor_blocks;
+    for (const auto& block : e_blocks) {
+        if (block.size() >= 3) xor_blocks.push_back(block);
+    }
+    if (xor_blocks.empty()) num_xors = 0;
+
+    for (int i = 0; i < num_xors; i++) {
+        const std::vector<int>& block = xor_blocks[rng() % xor_blocks.size()];
+        std::vector<int> pick = block;
+        std::shuffle(pick.begin(), pick.end(), rng);
+        addXor(f, pick[0], pick[1], pick[2], rng() & 1);
+    }
+
+    int width = std::max(1, std::min(p.width, f.num_vars));
+    std::vector<int> all(f.num_vars);
+    for (int v = 1; v <= f.num_vars; v++) all[v - 1] = v;
+    std::vector<char> is_e(f.num_vars + 1, 0);
+    for (int v : existentials) is_e[v] = 1;
+    for (int i = num_xors; i < constraints; i++) {
+        std::shuffle(all.begin(), all.end(), rng);
+        std::vector<int> vars(all.begin(), all.begin() + width);
+        // 只有一個 ∃ 文字的子句幾乎總是讓 ∀ 輕易獲勝 (Gent & Walsh)，
+        // 把 ∀ 文字換成 ∃ 文字，直到至少有兩個 (或全部都是 ∃)
+        int need = std::min<int>({2, width, (int)existentials.size()});
+        for (int tries = 0; tries < 4 * width; tries++) {
+            int count = std::count_if(vars.begin(), vars.end(), [&](int v) { return is_e[v]; });
+            if (count >= need) break;
+            int e = existentials[rng() % existentials.size()];
+            if (std::find(vars.begin(), vars.end(), e) != vars.end()) continue;
+            for (int& v : vars) {
+                if (!is_e[v]) {
+                    v = e;
+                    break;
+                }
+            }
+        }
+        std::vector<int> clause;
+        for (int v : vars) clause.push_back((rng() & 1) ? v : -v);
+        f.clauses.push_back(clause);
+    }
+    return f;
+}
+
+Formula genParity(const Params& p) {
+    Formula f;
+    int n = std::max(2, p.vars / 2);
+    std::vector<int> xs, ts;
+    for (int i = 1; i <= n; i++) xs.push_back(i);
+    for (int i = 1; i <= n; i++) ts.push_back(n + i);
+    f.num_vars = 2 * n;
+    f.prefix.push_back({'a', xs});
+    f.prefix.push_back({'e', ts});
+    f.clauses.push_back({-ts[0], xs[0]});
+    f.clauses.push_back({ts[0], -xs[0]});
+    for (int i = 1; i < n; i++) {
+        // ti XOR t(i-1) XOR xi = 0
+        addXor(f, ts[i], ts[i - 1], xs[i], false);
+    }
+    if (p.unsat) f.clauses.push_back({ts[n - 1]});
+    return f;
+}
+
+Formula genEqual(const Params& p) {
+    Formula f;
+    int n = std::max(1, p.vars / 2);
+    std::vector<int> xs, ys;
+    for (int i = 1; i <= n; i++) xs.push_back(i);
+    for (int i = 1; i <= n; i++) ys.push_back(n + i);
+    f.num_vars = 2 * n;
+    if (p.unsat) {
+        f.prefix.push_back({'e', ys});
+        f.prefix.push_back({'a', xs});
+    } else {
+        f.prefix.push_back({'a', xs});
+        f.prefix.push_back({'e', ys});
+    }
+    for (int i = 0; i < n; i++) {
+        f.clauses.push_back({-xs[i], ys[i]});
+        f.clauses.push_back({xs[i], -ys[i]});
+    }
+    return f;
+}
+
+std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    Params p;
+    p.family = argv[1];
+    std::string cmdline = argv[1];
+    for (int i = 2; i < argc; i++) {
+        cmdline += ' ';
+        cmdline += argv[i];
+        bool has_value = (i + 1 < argc);
+        if (std::strcmp(argv[i], "--unsat") == 0) {
+            p.unsat = true;
+            continue;
+        }
+        if (!has_value) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[i + 1];
+        if (std::strcmp(argv[i], "--vars") == 0) p.vars = std::atoi(value);
+        else if (std::strcmp(argv[i], "--depth") == 0) p.depth = std::atoi(value);
+        else if (std::strcmp(argv[i], "--first") == 0) p.first = value[0];
+        else if (std::strcmp(argv[i], "--blocks") == 0) p.blocks = parseList(value);
+        else if (std::strcmp(argv[i], "--ratio") == 0) p.ratio = std::atof(value);
+        else if (std::strcmp(argv[i], "--width") == 0) p.width = std::atoi(value);
+        else if (std::strcmp(argv[i], "--xor-density") == 0) p.xor_density = std::atof(value);
+        else if (std::strcmp(argv[i], "--seed") == 0) p.seed = std::strtoul(value, nullptr, 10);
+        else {
+            usage();
+            return 1;
+        }
+        cmdline += ' ';
+        cmdline += value;
+        i++;
+    }
+
+    Formula f;
+    if (p.family == "random") f = genRandom(p);
+    else if (p.family == "parity") f = genParity(p);
+    else if (p.family == "equal") f = genEqual(p);
+    else {
+        usage();
+        return 1;
+    }
+
+    std::cout << "c gen_qbf " << cmdline << "\n";
+    std::cout << "p cnf " << f.num_vars << " " << f.clauses.size() << "\n";
+    for (const auto& block : f.prefix) {
+        if (block.second.empty()) continue;
+        std::cout << block.first;
+        for (int v : block.second) std::cout << " " << v;
+        std::cout << " 0\n";
+    }
+    for (const auto& clause : f.clauses) {
+        for (int lit : clause) std::cout << lit << " ";
+        std::cout << "0\n";
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# 重新產生 bench/corpus：make bench-corpus
+# 用法：make_corpus.sh <gen_qbf 執行檔> <輸出目錄>
+set -e
+GEN=$1
+OUT=$2
+mkdir -p "$OUT"
+
+gen() {
+    name=$1
+    shift
+    "$GEN" "$@" > "$OUT/$name.qdimacs"
+}
+
+# 隨機：prefix 深度與子句/變數比例
+gen rand_d3_r1.5_s2        random --vars 40 --depth 3 --first e --ratio 1.5 --seed 2
+gen rand_d3_r1.8_s3        random --vars 40 --depth 3 --first e --ratio 1.8 --seed 3
+gen rand_d3_r2.5_s3        random --vars 40 --depth 3 --first e --ratio 2.5 --seed 3
+gen rand_d5_r2.0_s2        random --vars 50 --depth 5 --first e --ratio 2.0 --seed 2
+gen rand_d3_w4_r4.0_s1     random --vars 60 --depth 3 --first e --ratio 4.0 --width 4 --seed 1
+
+# 區塊大小不平均
+gen rand_a3e37_r3.0_s1     random --blocks 3,37 --first a --ratio 3.0 --seed 1
+gen rand_a3e37_r3.0_s2     random --blocks 3,37 --first a --ratio 3.0 --seed 2
+gen rand_a6e34_r2.5_s1     random --blocks 6,34 --first a --ratio 2.5 --seed 1
+gen rand_a6e34_r2.5_s3     random --blocks 6,34 --first a --ratio 2.5 --seed 3
+gen rand_e10a5e30_r2.0_s1  random --blocks 10,5,30 --first e --ratio 2.0 --seed 1
+gen rand_e10a5e30_r2.0_s3  random --blocks 10,5,30 --first e --ratio 2.0 --seed 3
+gen rand_e10a3e30_r2.5_s1  random --blocks 10,3,30 --first e --ratio 2.5 --seed 1
+gen rand_e20a3e30_r3.0_s2  random --blocks 20,3,30 --first e --ratio 3.0 --seed 2
+gen rand_e20a3e30_r3.0_s3  random --blocks 20,3,30 --first e --ratio 3.0 --seed 3
+
+# XOR 比例
+gen rand_xor0.2_s1         random --vars 45 --depth 3 --first e --ratio 1.5 --xor-density 0.2 --seed 1
+gen rand_xor0.2_s3         random --vars 45 --depth 3 --first e --ratio 1.5 --xor-density 0.2 --seed 3
+
+# 結構化
+gen parity_20              parity --vars 40
+gen parity_20_unsat        parity --vars 40 --unsat
+gen equal_16               equal --vars 32
+gen equal_16_unsat         equal --vars 32 --unsat
@@ -0,0 +1,28 @@
+#include "clause_db.h"
+#include <cstdlib>
+
+void ClauseDB::reserve(size_t num_clauses, size_t num_literals) {
+    offsets.reserve(num_clauses + 1);
+    literals.reserve(num_literals);
+}
+
+void ClauseDB::addLiteral(int lit) {
+    literals.push_back(lit);
+    int var = std::abs(lit);
+    if (var > max_var) max_var = var;
+}
+
+void ClauseDB::endClause() {
+    offsets.push_back(literals.size());
+}
+
+void ClauseDB::addClause(const std::vector<int>& clause) {
+    for (int lit : clause) addLiteral(lit);
+    endClause();
+}
+
+void ClauseDB::clear() {
+    offsets.assign(1, 0);
+    literals.clear();
+    max_var = 0;
+}
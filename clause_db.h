@@ -0,0 +1,67 @@
+#ifndef CLAUSE_DB_H
+#define CLAUSE_DB_H
+
+#include <cstddef>
+#include <vector>
+
+// 連續儲存的子句資料庫 (CSR)：
+//   literals 依序存放所有子句的文字
+//   offsets[i] .. offsets[i+1] 為第 i 個子句在 literals 中的範圍
+// 載入完成後視為唯讀 (增量模式只會在尾端加入子句)，各層以參考共用同一份。
+class ClauseDB {
+public:
+    // 單一子句的唯讀視圖，不擁有記憶體
+    class Clause {
+    public:
+        Clause(const int* first, const int* last) : first(first), last(last) {}
+        const int* begin() const { return first; }
+        const int* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+        int operator[](size_t i) const { return first[i]; }
+    private:
+        const int* first;
+        const int* last;
+    };
+
+    // 依序走訪所有子句
+    class iterator {
+    public:
+        iterator(const ClauseDB* db, size_t index) : db(db), index(index) {}
+        Clause operator*() const { return (*db)[index]; }
+        iterator& operator++() { ++index; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+    private:
+        const ClauseDB* db;
+        size_t index;
+    };
+
+    ClauseDB() : offsets(1, 0) {}
+
+    size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+    size_t numLiterals() const { return literals.size(); }
+    int maxVar() const { return max_var; }
+
+    Clause operator[](size_t i) const {
+        const int* base = literals.data();
+        return Clause(base + offsets[i], base + offsets[i + 1]);
+    }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+    // 以下只在載入階段使用
+    void reserve(size_t num_clauses, size_t num_literals);
+    void addLiteral(int lit);   // 加到目前尚未結束的子句
+    void endClause();           // 結束目前的子句 (可為空子句)
+    void addClause(const std::vector<int>& clause);
+    void clear();
+
+private:
+    std::vector<size_t> offsets;
+    std::vector<int> literals;
+    int max_var = 0;
+};
+
+#endif
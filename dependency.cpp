@@ -0,0 +1,277 @@
+#include "dependency.h"
+#include "miniscope.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace {
+
+int findRoot(std::vector<int>& parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace
+
+void DependencyAnalysis::run(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& in, ClauseDB& out) {
+    auto start = std::chrono::steady_clock::now();
+    st = Stats();
+    st.blocks_before = prefix.size();
+
+    // 1. D^rrs：加強的 universal reduction
+    buildTables(prefix, in);
+    if (options.reduce) {
+        reduce(in, out);
+    } else {
+        out = in;
+    }
+
+    // 2. D^std：在化簡後的 matrix 上重新排列 prefix
+    if (options.reorder) {
+        if (st.reduced_literals > 0) buildTables(prefix, out);
+        reorder(prefix, out);
+    }
+    st.blocks_after = prefix.size();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void DependencyAnalysis::buildTables(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix) {
+    int n = matrix.maxVar();
+    for (const auto& block : prefix) {
+        for (int var : block.vars) n = std::max(n, var);
+    }
+    level.assign(n + 1, -1);
+    quantifier.assign(n + 1, 'e');
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        for (int var : prefix[depth].vars) {
+            level[var] = depth;
+            quantifier[var] = prefix[depth].quantifier;
+        }
+    }
+
+    // 出現表：先數每個文字的出現次數，再填入
+    occ_start.assign(2 * (n + 1) + 1, 0);
+    for (const auto& clause : matrix) {
+        for (int lit : clause) occ_start[litIndex(lit) + 1]++;
+    }
+    for (size_t i = 1; i < occ_start.size(); i++) occ_start[i] += occ_start[i - 1];
+    occ.resize(occ_start.back());
+    std::vector<size_t> fill(occ_start.begin(), occ_start.end() - 1);
+    int c = 0;
+    for (const auto& clause : matrix) {
+        for (int lit : clause) occ[fill[litIndex(lit)]++] = c;
+        c++;
+    }
+}
+
+// 從子句 c (經由變數 var 進入) 往外走：可以經由任何其他 ∃ 文字離開。
+// 同一個子句最多展開兩次：第二次只補上第一次進入時不能走的那個變數
+void DependencyAnalysis::enterClause(int c, int var, int min_level, const ClauseDB& matrix, std::vector<int>& stamp, long long& work) {
+    int only = 0;
+    if (clause_stamp[c] != search) {
+        clause_stamp[c] = search;
+        clause_entry[c] = var;
+    } else {
+        if (clause_entry[c] == -1 || clause_entry[c] == var) return;
+        only = clause_entry[c];
+        clause_entry[c] = -1;
+    }
+    ClauseDB::Clause clause = matrix[c];
+    work += clause.size();
+    for (int lit : clause) {
+        int v = std::abs(lit);
+        if (quantifier[v] != 'e' || level[v] <= min_level) continue;
+        if (only != 0 ? v != only : v == var) continue;
+        if (stamp[litIndex(lit)] == search) continue;
+        stamp[litIndex(lit)] = search;
+        queue.push_back(lit);
+    }
+}
+
+// 標記從文字 lit 出發、經由 lit 內層的 ∃ 變數，resolution path 能到達的所有 ∃ 文字
+// (stamp[litIndex(l)] == 回傳值)。超過預算時回傳 -1
+int DependencyAnalysis::reachable(int lit, const ClauseDB& matrix, std::vector<int>& stamp, long long& work) {
+    search++;
+    int min_level = level[std::abs(lit)];
+    queue.clear();
+    for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1]; i++) {
+        enterClause(occ[i], std::abs(lit), min_level, matrix, stamp, work);
+    }
+    // 離開文字 l 的 path 進入含有 ¬l 的子句
+    for (size_t head = 0; head < queue.size(); head++) {
+        if (work > options.rrs_budget) return -1;
+        int l = queue[head];
+        for (size_t i = occ_start[litIndex(-l)]; i < occ_start[litIndex(-l) + 1]; i++) {
+            enterClause(occ[i], std::abs(l), min_level, matrix, stamp, work);
+        }
+    }
+    return search;
+}
+
+// 子句中的 ∀ 文字 u，若子句中沒有任何內層的 ∃ 文字依賴 u (D^rrs)，就刪掉。
+// 依賴關係以原公式計算一次：每個刪除都是 Q(D^rrs)-resolution 的一步，因此可以同時套用
+void DependencyAnalysis::reduce(const ClauseDB& in, ClauseDB& out) {
+    int n = level.size() - 1;
+    int m = in.size();
+    clause_stamp.assign(m, 0);
+    clause_entry.assign(m, 0);
+    search = 0;
+
+    // 1. 子句是否為 tautology (不動它)，以及每個子句在 drop 中的起點
+    std::vector<size_t> first(m + 1, 0);
+    std::vector<char> tautology(m, 0);
+    std::vector<int> mark(2 * (n + 1), -1);
+    for (int c = 0; c < m; c++) {
+        ClauseDB::Clause clause = in[c];
+        first[c + 1] = first[c] + clause.size();
+        for (int lit : clause) {
+            if (mark[litIndex(-lit)] == c) tautology[c] = 1;
+            mark[litIndex(lit)] = c;
+        }
+    }
+    std::vector<char> drop(first[m], 0);
+
+    // 2. 對每個 ∀ 變數 u 求兩個方向的可達集合
+    std::vector<int> from_pos(2 * (n + 1), 0), from_neg(2 * (n + 1), 0);
+    long long work = 0;
+    for (int u = 1; u <= n; u++) {
+        if (level[u] < 0 || quantifier[u] != 'a') continue;
+        if (occ_start[litIndex(u)] == occ_start[litIndex(u) + 1] && occ_start[litIndex(-u)] == occ_start[litIndex(-u) + 1]) continue;
+
+        // 只有在子句中同時有內層 ∃ 文字時才需要搜尋
+        bool needs_paths = false;
+        for (int lit : {u, -u}) {
+            for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1] && !needs_paths; i++) {
+                for (int other : in[occ[i]]) {
+                    int v = std::abs(other);
+                    if (quantifier[v] == 'e' && level[v] > level[u]) needs_paths = true;
+                }
+            }
+        }
+        int pos_id = -2, neg_id = -2;
+        if (needs_paths) {
+            pos_id = reachable(u, in, from_pos, work);
+            neg_id = (pos_id < 0) ? -1 : reachable(-u, in, from_neg, work);
+            if (neg_id < 0) {
+                st.reduce_skipped = true;
+                st.reduced_literals = 0;
+                out = in;
+                return;
+            }
+        }
+
+        for (int lit : {u, -u}) {
+            for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1]; i++) {
+                int c = occ[i];
+                if (tautology[c]) continue;
+                ClauseDB::Clause clause = in[c];
+                bool depends = false;
+                for (int e : clause) {
+                    int v = std::abs(e);
+                    if (quantifier[v] != 'e' || level[v] <= level[u]) continue;
+                    bool same = from_pos[litIndex(v)] == pos_id && from_neg[litIndex(-v)] == neg_id;
+                    bool crossed = from_pos[litIndex(-v)] == pos_id && from_neg[litIndex(v)] == neg_id;
+                    if (same || crossed) {
+                        depends = true;
+                        break;
+                    }
+                }
+                if (depends) continue;
+                for (size_t j = 0; j < clause.size(); j++) {
+                    if (clause[j] == lit && !drop[first[c] + j]) {
+                        drop[first[c] + j] = 1;
+                        st.reduced_literals++;
+                    }
+                }
+            }
+        }
+    }
+
+    // 3. 寫出化簡後的子句
+    out.clear();
+    out.reserve(m, first[m] - st.reduced_literals);
+    for (int c = 0; c < m; c++) {
+        ClauseDB::Clause clause = in[c];
+        for (size_t j = 0; j < clause.size(); j++) {
+            if (!drop[first[c] + j]) out.addLiteral(clause[j]);
+        }
+        out.endClause();
+    }
+}
+
+// 依 D^std 重新排列：由外往內逐區塊處理。對區塊 d，以 d 內層的 ∃ 變數把子句連成分量；
+// 內層量詞不同的變數 y 若與區塊 d 的某個變數 x 落在同一分量，y 必須放在 x 的新區塊之後。
+// 每個變數放到滿足所有依賴、且量詞相同的最外層區塊。
+bool DependencyAnalysis::reorder(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix) {
+    int depth_count = prefix.size();
+    if (depth_count <= 2) return false;
+    int n = level.size() - 1;
+    int m = matrix.size();
+    char outer = prefix[0].quantifier;
+    char inner = (outer == 'e') ? 'a' : 'e';
+    auto quantifierAt = [&](int k) { return (k % 2 == 0) ? outer : inner; };
+
+    std::vector<int> floor(n + 1, -1);  // 依賴的變數中最內層的新區塊
+    std::vector<int> new_level(n + 1, -1);
+    std::vector<int> parent(m), best(m);
+    for (int d = 0; d < depth_count; d++) {
+        // 1. 區塊 d 的新位置 (所有依賴都在外層區塊，已經決定)
+        for (int x : prefix[d].vars) {
+            int k = floor[x] + 1;
+            if (quantifierAt(k) != quantifier[x]) k++;
+            new_level[x] = k;
+        }
+        if (d == depth_count - 1) break;
+
+        // 2. 以 d 內層的 ∃ 變數連通子句
+        std::iota(parent.begin(), parent.end(), 0);
+        for (int v = 1; v <= n; v++) {
+            if (level[v] <= d || quantifier[v] != 'e') continue;
+            int root = -1;
+            for (int lit : {v, -v}) {
+                for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1]; i++) {
+                    int other = findRoot(parent, occ[i]);
+                    if (root < 0) root = other;
+                    else if (other != root) parent[other] = root;
+                }
+            }
+        }
+
+        // 3. 每個分量中區塊 d 的變數最內層的新區塊，傳給內層量詞不同的變數
+        std::fill(best.begin(), best.end(), -1);
+        for (int x : prefix[d].vars) {
+            for (int lit : {x, -x}) {
+                for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1]; i++) {
+                    int root = findRoot(parent, occ[i]);
+                    best[root] = std::max(best[root], new_level[x]);
+                }
+            }
+        }
+        for (int y = 1; y <= n; y++) {
+            if (level[y] <= d || quantifier[y] == prefix[d].quantifier) continue;
+            for (int lit : {y, -y}) {
+                for (size_t i = occ_start[litIndex(lit)]; i < occ_start[litIndex(lit) + 1]; i++) {
+                    floor[y] = std::max(floor[y], best[findRoot(parent, occ[i])]);
+                }
+            }
+        }
+    }
+
+    // 4. 依新區塊重建 prefix (區塊內維持原本的順序)
+    int max_level = 0;
+    for (int v = 1; v <= n; v++) max_level = std::max(max_level, new_level[v]);
+    std::vector<QBFSolver::Formula> result(max_level + 1);
+    for (int k = 0; k <= max_level; k++) result[k].quantifier = quantifierAt(k);
+    for (int d = 0; d < depth_count; d++) {
+        for (int var : prefix[d].vars) {
+            if (new_level[var] < d) st.moved_vars++;
+            result[new_level[var]].vars.push_back(var);
+        }
+    }
+    mergeBlocks(result);
+    prefix = std::move(result);
+    return st.moved_vars > 0;
+}
@@ -0,0 +1,73 @@
+#ifndef DEPENDENCY_H
+#define DEPENDENCY_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <vector>
+
+// 依賴關係分析 (dependency schemes)：線性的 prefix 假設內層變數依賴所有外層變數，
+// 但 matrix 常常證明並非如此。這裡計算兩種依賴關係：
+//
+//   standard (D^std)        : y 依賴 x (x 在 y 外層、量詞不同)，若含有 x 與含有 y 的子句
+//                             能經由 x 內層的 ∃ 變數連通。用來重新排列 prefix：
+//                             每個變數移到它真正依賴的變數之後最外層的同量詞區塊，
+//                             區塊數 (交替次數) 只會變少。
+//   resolution-path (D^rrs) : ∃ 變數 e 依賴 ∀ 變數 u，若有一對 resolution path 連接
+//                             u 到 e 與 ¬u 到 ¬e (或 u 到 ¬e 與 ¬u 到 e)，
+//                             path 只經過 u 內層的 ∃ 變數，且相鄰兩步不可經由同一個變數。
+//                             用來加強 universal reduction：子句中的 ∀ 文字 u，
+//                             若子句中沒有任何 ∃ 文字依賴 u，就可以刪掉
+//                             (即使有 ∃ 文字在 u 的內層)。
+//
+// 兩者都只重新排列變數或刪除 ∀ 文字，公式的真假不變。
+class DependencyAnalysis {
+public:
+    struct Options {
+        bool reorder = true;            // 依 D^std 重新排列 prefix
+        bool reduce = true;             // 依 D^rrs 做 universal reduction
+        long long rrs_budget = 100000000; // D^rrs 搜尋最多走訪的文字數，超過時不做 reduction
+    };
+
+    struct Stats {
+        int blocks_before = 0;
+        int blocks_after = 0;
+        int moved_vars = 0;             // 移到較外層區塊的變數
+        int reduced_literals = 0;       // D^rrs reduction 刪掉的 ∀ 文字
+        bool reduce_skipped = false;    // 超過 rrs_budget
+        double seconds = 0;
+    };
+
+    explicit DependencyAnalysis(const Options& options) : options(options) {}
+
+    // 先以 D^rrs 化簡 in 寫進 out，再依 out 的 D^std 重新排列 prefix (空區塊會被移除、相鄰同量詞區塊合併)
+    void run(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& in, ClauseDB& out);
+
+    const Stats& stats() const { return st; }
+
+private:
+    Options options;
+    Stats st;
+
+    std::vector<int> level;             // 以變數編號索引，未量化為 -1
+    std::vector<char> quantifier;
+
+    // 出現表 (CSR，以文字索引)
+    std::vector<size_t> occ_start;
+    std::vector<int> occ;
+
+    // resolution path 搜尋的暫存 (以時間戳記代替清除)
+    std::vector<int> clause_stamp;
+    std::vector<int> clause_entry;      // 進入子句時經過的變數，-1 表示兩種方向都已展開
+    std::vector<int> queue;
+    int search = 0;                     // 目前搜尋的時間戳記
+
+    static int litIndex(int lit) { return 2 * std::abs(lit) + (lit < 0); }
+
+    void buildTables(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix);
+    void reduce(const ClauseDB& in, ClauseDB& out);
+    int reachable(int lit, const ClauseDB& matrix, std::vector<int>& stamp, long long& work);
+    void enterClause(int c, int var, int min_level, const ClauseDB& matrix, std::vector<int>& stamp, long long& work);
+    bool reorder(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix);
+};
+
+#endif
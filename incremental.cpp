@@ -0,0 +1,96 @@
+#include "log.h"
+#include "miniscope.h"
+#include "qbf.h"
+#include <algorithm>
+#include <cstdlib>
+
+// 增量介面：抽象只在 load 時建立一次，之後的查詢沿用各層的 alpha 與細化子句。
+// 公式只會變得更難滿足 (加入子句)，因此 ∃ 的細化一直有效；∀ 的細化以 generation 文字保護。
+
+void QBFSolver::load(const std::vector<Formula>& prefix, const ClauseDB& matrix) {
+    start_time = std::chrono::steady_clock::now();
+    st = Stats();
+    st.clauses_before = matrix.size();
+    st.clauses_after = matrix.size();
+
+    // 1. 複製公式；只合併區塊，不移除變數 (之後的子句可能用到)
+    work_prefix = prefix;
+    mergeBlocks(work_prefix);
+    work_matrix = matrix;
+    st.prefix_blocks = work_prefix.size();
+
+    // 2. 建立各層的抽象
+    incremental = true;
+    selector_stride = 3;
+    generation = 0;
+    generation_stale = false;
+    outer_assumptions.clear();
+
+    int max_ID = maxVarOf(work_prefix, work_matrix);
+    buildVarTable(work_prefix, max_ID);
+    initLevelStats(work_prefix);
+    buildAbstraction(work_prefix, work_matrix, max_ID);
+    LOG_INFO("incremental load : " << (int)work_matrix.size() << " clauses, " << (int)work_prefix.size() << " blocks");
+}
+
+bool QBFSolver::addClause(const std::vector<int>& clause) {
+    // 1. 只接受已被量化的變數
+    int depth = -1;
+    for (int lit : clause) {
+        int var = std::abs(lit);
+        if (var == 0 || var >= (int)var_info.size() || levelOf(var) < 0) return false;
+        depth = std::max(depth, levelOf(var));
+    }
+
+    // 2. 加到公式，由外往內找到 (或建立) 每一層的群組，並在最外層設為有效。
+    //    加入既有群組的子句只讓交給內層的群組變大，∃ 的細化子句仍然成立
+    int i = work_matrix.size();
+    work_matrix.addClause(clause);
+    clause_depth.push_back(depth);
+    int group = -1;
+    for (int d = 0; d < (int)levels.size(); d++) {
+        group = groupOf(d, group, i);
+        if (d == 0) setActive(0, group, true);
+        st.levels[d].groups = levels[d]->rep.size();
+        st.levels[d].peak_clauses = std::max(st.levels[d].peak_clauses, (int)levels[d]->alpha.numClauses());
+    }
+
+    // 3. 目前 generation 的 ∀ 細化與各層快取的結果不再可靠
+    generation_stale = true;
+    clearResultCaches();
+    st.clauses_after = work_matrix.size();
+    return true;
+}
+
+// 讓目前的 ∀ 細化與覆蓋子句失效，改用新的 generation 文字
+void QBFSolver::nextGeneration() {
+    int old_literal = generationLiteral();
+    generation++;
+    for (int depth = 0; depth < (int)levels.size(); depth++) {
+        if (levels[depth]->quantifier != 'a') continue;
+        levels[depth]->alpha.addClause({-old_literal});
+        if (levels[depth]->is_last) addLeafCover(depth);
+    }
+    generation_stale = false;
+    LOG_DEBUG("incremental generation " << generation);
+}
+
+QBFResult QBFSolver::solveAssuming(const std::vector<int>& assumptions) {
+    auto call_start = std::chrono::steady_clock::now();
+    if (!incremental) return Q_UNKNOWN;
+    for (int lit : assumptions) {
+        int var = std::abs(lit);
+        if (var == 0 || var >= (int)var_info.size() || levelOf(var) != 0) return Q_UNKNOWN;
+    }
+    if (levels.empty()) return work_matrix.empty() ? Q_SAT : Q_UNSAT;
+
+    if (generation_stale) nextGeneration();
+    st.out_of_budget = false;
+    startBudget();
+    outer_assumptions = assumptions;
+    QBFResult res = solveLevels(work_prefix);
+    stopBudget();
+    outer_assumptions.clear();
+    st.seconds += elapsedSeconds(call_start);
+    return res;
+}
@@ -0,0 +1,25 @@
+#include "log.h"
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace qbflog {
+
+namespace {
+std::ofstream file;
+std::mutex log_mutex;
+} // namespace
+
+std::ostream& out() {
+    if (file.is_open()) return file;
+    return std::cout;
+}
+
+bool openFile(const char* path) {
+    file.open(path);
+    return file.is_open();
+}
+
+std::mutex& mutex() { return log_mutex; }
+
+} // namespace qbflog
@@ -0,0 +1,55 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <mutex>
+#include <ostream>
+
+// 編譯期決定的 log 等級 (以 -DQBF_LOG_LEVEL=N 指定)：
+//   0 : 不輸出任何訊息
+//   1 : info  —— 每次求解幾行摘要 (前處理、XOR、prefix 大小)，release 預設
+//   2 : debug —— 每次進入一層、基底情況、細化
+//   3 : trace —— 每個候選賦值 (整個 vars_of_interest)
+// 高於 QBF_LOG_LEVEL 的 LOG_* 會被前處理器整個移除，參數不會被求值，
+// 因此 release 版的 CEGAR 迴圈裡沒有任何輸出成本。
+#ifndef QBF_LOG_LEVEL
+#define QBF_LOG_LEVEL 1
+#endif
+
+namespace qbflog {
+
+// log 的輸出目的地：openFile 成功後為該檔案，否則為 std::cout
+std::ostream& out();
+
+// 把 debug / trace 訊息改寫到檔案；失敗時回傳 false
+bool openFile(const char* path);
+
+// 多個 thread 同時求解子問題時，整行寫出避免交錯
+std::mutex& mutex();
+
+} // namespace qbflog
+
+// 每則訊息一行，以 '\n' 結尾而不是 std::endl，不會每行都 flush。
+// 以 lock_guard 持有 mutex：格式化時丟出例外 (例如 bad_alloc) 也會解鎖
+#define QBF_LOG_WRITE(msg) do { std::lock_guard<std::mutex> qbf_log_guard(qbflog::mutex()); qbflog::out() << msg << '\n'; } while (0)
+
+#if QBF_LOG_LEVEL >= 1
+#define LOG_INFO(msg) QBF_LOG_WRITE(msg)
+#else
+#define LOG_INFO(msg) do {} while (0)
+#endif
+
+#if QBF_LOG_LEVEL >= 2
+#define LOG_DEBUG(msg) QBF_LOG_WRITE(msg)
+#else
+#define LOG_DEBUG(msg) do {} while (0)
+#endif
+
+#if QBF_LOG_LEVEL >= 3
+#define LOG_TRACE(msg) QBF_LOG_WRITE(msg)
+#define LOG_TRACE_ENABLED 1
+#else
+#define LOG_TRACE(msg) do {} while (0)
+#define LOG_TRACE_ENABLED 0
+#endif
+
+#endif
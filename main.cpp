@@ -1,22 +1,207 @@
-
+#include "batch.h"
+#include "log.h"
+#include "portfolio.h"
 #include "qbf.h"
+#include "qdimacs.h"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+
+static void usage(const char* prog) {
+    std::cerr << "usage: " << prog << " [options] <file.qdimacs | ->" << std::endl
+              << "       " << prog << " --batch N [options] [files... | -]" << std::endl
+              << "  --no-xor     do not recover XOR constraints from the CNF" << std::endl
+              << "  --no-gauss   keep XORs but disable Gauss-Jordan elimination" << std::endl
+              << "  --no-minimize  block every selector instead of the UNSAT core" << std::endl
+              << "  --no-preprocess  skip preprocessing entirely" << std::endl
+              << "  --no-ur / --no-up / --no-pure / --no-bce" << std::endl
+              << "               disable universal reduction, unit propagation," << std::endl
+              << "               pure literal or blocked clause elimination" << std::endl
+              << "  --no-dependencies  keep the linear prefix (no dependency-scheme" << std::endl
+              << "               reordering or dependency-aware universal reduction)" << std::endl
+              << "  --no-miniscope  solve the formula as one piece" << std::endl
+              << "  --no-2qbf    use the general engine for two-block prefixes too" << std::endl
+              << "  --time-limit SEC  give up with UNKNOWN after SEC seconds (per file in --batch)" << std::endl
+              << "  --conflict-limit N  give up with UNKNOWN when one SAT call needs more" << std::endl
+              << "               than N conflicts" << std::endl
+              << "  --small-sat N  use the built-in CDCL engine for SAT solvers with at most" << std::endl
+              << "               N variables (0: always CryptoMiniSat, default 100)" << std::endl
+              << "  --result-cache N  remember up to N inner-level results per level and reuse" << std::endl
+              << "               them when the same clauses are active again (0: off, default 1024)" << std::endl
+              << "  --threads N  solve up to N independent components concurrently" << std::endl
+              << "  --seed N     random seed for CryptoMiniSat (with --portfolio, member i" << std::endl
+              << "               uses N + i)" << std::endl
+              << "  --trace FILE write log output to FILE (per-iteration traces need" << std::endl
+              << "               a build with QBF_LOG_LEVEL >= 3, e.g. make debug)" << std::endl
+              << "  --stats FILE write per-level statistics as JSON to FILE (- for stdout)," << std::endl
+              << "               at the end of the run, also after SIGINT once the solvers have" << std::endl
+              << "               stopped (with --portfolio: the winning configuration, or the" << std::endl
+              << "               first one if there is no winner); a second SIGINT exits at once" << std::endl
+              << "  --portfolio N  race N differently configured solvers in parallel" << std::endl
+              << "               and report the configuration that answered first" << std::endl
+              << "  --batch N    solve every file on N worker threads, one result line" << std::endl
+              << "               \"id SAT|UNSAT|UNKNOWN|ERROR seconds\" per file in input order;" << std::endl
+              << "               without files (or with -) read \"path\" or \"id path\" lines from stdin" << std::endl
+              << "  --unordered  with --batch, print each result as soon as it is known" << std::endl;
+}
+
+// --stats 的輸出 (path 為 "-" 時寫到 stdout)
+static void dumpStats(const QBFSolver& solver, const char* path) {
+    if (path == nullptr) return;
+    if (std::strcmp(path, "-") == 0) {
+        solver.writeStatsJson(std::cout);
+        return;
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "cannot write stats to " << path << std::endl;
+        return;
+    }
+    solver.writeStatsJson(file);
+}
+
+// 與 minisat 相同：被中斷時仍輸出目前為止的統計。
+// handler 只設定旗標並要求 solver 停下 (interrupt 只寫 lock-free 的 atomic)；
+// 主 thread 等 solve 回傳 (portfolio 的 worker 都已結束) 後才輸出，不與求解中的 thread 競爭。
+// 第二次 SIGINT 使用預設處理，直接結束
+static_assert(std::atomic<bool>::is_always_lock_free, "QBFSolver::interrupt must be async-signal-safe");
+static volatile std::sig_atomic_t sigint_received = 0;
+static QBFSolver* sigint_solver = nullptr;
+static Portfolio* sigint_portfolio = nullptr;
+
+static void sigintHandler(int) {
+    sigint_received = 1;
+    std::signal(SIGINT, SIG_DFL);
+    if (sigint_solver != nullptr) sigint_solver->interrupt();
+    if (sigint_portfolio != nullptr) sigint_portfolio->interrupt();
+}
 
-int main() {
+int main(int argc, char** argv) {
     QBFSolver solver;
+    const char* path = nullptr;
+    int portfolio_size = 1;
+    int batch_workers = 0;
+    bool batch_ordered = true;
+    std::vector<BatchRunner::Job> batch_jobs;
+    bool has_trace = false;
+    const char* stats_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--no-xor") == 0) {
+            solver.options.use_xor = false;
+        } else if (std::strcmp(argv[i], "--no-gauss") == 0) {
+            solver.options.gauss = false;
+        } else if (std::strcmp(argv[i], "--no-minimize") == 0) {
+            solver.options.minimize_refinement = false;
+        } else if (std::strcmp(argv[i], "--no-preprocess") == 0) {
+            solver.options.preprocess = false;
+        } else if (std::strcmp(argv[i], "--no-ur") == 0) {
+            solver.options.universal_reduction = false;
+        } else if (std::strcmp(argv[i], "--no-up") == 0) {
+            solver.options.unit_propagation = false;
+        } else if (std::strcmp(argv[i], "--no-pure") == 0) {
+            solver.options.pure_literals = false;
+        } else if (std::strcmp(argv[i], "--no-bce") == 0) {
+            solver.options.blocked_clauses = false;
+        } else if (std::strcmp(argv[i], "--no-dependencies") == 0) {
+            solver.options.dependencies = false;
+        } else if (std::strcmp(argv[i], "--no-miniscope") == 0) {
+            solver.options.miniscope = false;
+        } else if (std::strcmp(argv[i], "--no-2qbf") == 0) {
+            solver.options.two_qbf = false;
+        } else if (std::strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            solver.options.time_limit = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--conflict-limit") == 0 && i + 1 < argc) {
+            solver.options.conflict_limit = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--small-sat") == 0 && i + 1 < argc) {
+            solver.options.small_sat_vars = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--result-cache") == 0 && i + 1 < argc) {
+            solver.options.result_cache = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            solver.options.component_threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            solver.options.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            if (!qbflog::openFile(argv[++i])) {
+                std::cerr << "cannot open trace file " << argv[i] << std::endl;
+                return 1;
+            }
+            has_trace = true;
+        } else if (std::strcmp(argv[i], "--portfolio") == 0 && i + 1 < argc) {
+            portfolio_size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            stats_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_workers = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--unordered") == 0) {
+            batch_ordered = false;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            path = argv[i];
+            if (std::strcmp(path, "-") != 0) batch_jobs.push_back({path, path});
+        }
+    }
 
-    // 範例：forall x1, exists x2 . (x1 != x2)
-    std::vector<QBFSolver::Formula> prefix = {
-        {'a', {1}}, 
-        {'e', {2, 3}}
-    };
-    std::vector<std::vector<int>> matrix = { {1, 2}};
+    if (batch_workers > 0) {
+        // 各個求解的 info log 不混進結果行；需要時以 --trace 指定檔案
+        if (!has_trace && !qbflog::openFile("/dev/null")) return 1;
+        if (batch_jobs.empty()) BatchRunner::readJobs(std::cin, batch_jobs);
+        BatchRunner batch(batch_workers, solver.options);
+        batch.run(batch_jobs, std::cout, batch_ordered);
+        std::cerr << "batch : " << batch_jobs.size() << " instances, " << batch.solved() << " solved, "
+                  << batch.errors() << " errors, " << batch.seconds() << " s ("
+                  << (batch.seconds() > 0 ? batch_jobs.size() / batch.seconds() : 0) << " instances/s)" << std::endl;
+        return batch.errors() > 0 ? 1 : 0;
+    }
+    if (path == nullptr) {
+        usage(argv[0]);
+        return 1;
+    }
 
+    std::vector<QBFSolver::Formula> prefix;
+    ClauseDB matrix;
+    std::string error;
+    if (!parseQDIMACS(path, prefix, matrix, error)) {
+        std::cerr << "parse error: " << error << std::endl;
+        return 1;
+    }
 
-    QBFResult res = solver.solve(prefix, matrix);
-    std::cout << "QBF Result: " << (res == Q_SAT ? "SAT" : "UNSAT") << std::endl;
+    QBFResult res;
+    const QBFSolver* stats_solver = &solver;
+    std::unique_ptr<Portfolio> portfolio;
+    if (portfolio_size > 1) {
+        // portfolio 模式的統計取自勝出的 solver；沒有勝出者時 (SIGINT) 取自第一個設定
+        portfolio = std::make_unique<Portfolio>(Portfolio::defaultConfigs(portfolio_size, solver.options));
+        sigint_portfolio = portfolio.get();
+        std::signal(SIGINT, sigintHandler);
+        res = portfolio->solve(prefix, matrix);
+        if (portfolio->winner() >= 0) {
+            std::cout << "portfolio winner : " << portfolio->winnerConfig().name << std::endl;
+            stats_solver = &portfolio->winnerSolver();
+        } else if (portfolio->size() > 0) {
+            stats_solver = &portfolio->solver(0);
+        }
+    } else {
+        sigint_solver = &solver;
+        std::signal(SIGINT, sigintHandler);
+        res = solver.solve(prefix, matrix);
+    }
+    std::signal(SIGINT, SIG_DFL);
+    bool interrupted = sigint_received && res == Q_UNKNOWN;
+    if (interrupted) std::cout << "*** INTERRUPTED ***" << std::endl;
+    std::cout << "QBF Result: " << (res == Q_SAT ? "SAT" : res == Q_UNSAT ? "UNSAT" : "UNKNOWN") << std::endl;
+    dumpStats(*stats_solver, stats_path);
 
-    return 0;
+    // 與 QDIMACS 慣例相同：SAT 回傳 10，UNSAT 回傳 20，未知為 0 (被中斷為 1)
+    if (interrupted) return 1;
+    if (res == Q_UNKNOWN) return 0;
+    return (res == Q_SAT) ? 10 : 20;
 }
 
 // SAT solver test
@@ -0,0 +1,114 @@
+#include "miniscope.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+namespace {
+
+int findRoot(std::vector<int>& parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+int maxPrefixVar(const std::vector<QBFSolver::Formula>& prefix) {
+    int n = 0;
+    for (const auto& block : prefix) {
+        for (int var : block.vars) n = std::max(n, var);
+    }
+    return n;
+}
+
+} // namespace
+
+bool normalizePrefix(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix) {
+    std::vector<char> occurs(std::max(matrix.maxVar(), maxPrefixVar(prefix)) + 1, 0);
+    for (const auto& clause : matrix) {
+        for (int lit : clause) occurs[std::abs(lit)] = 1;
+    }
+
+    bool changed = false;
+    for (auto& block : prefix) {
+        size_t before = block.vars.size();
+        block.vars.erase(std::remove_if(block.vars.begin(), block.vars.end(), [&](int var) { return !occurs[var]; }), block.vars.end());
+        if (block.vars.size() != before) changed = true;
+    }
+    if (mergeBlocks(prefix)) changed = true;
+    return changed;
+}
+
+bool mergeBlocks(std::vector<QBFSolver::Formula>& prefix) {
+    bool changed = false;
+    std::vector<QBFSolver::Formula> result;
+    for (auto& block : prefix) {
+        if (block.vars.empty()) {
+            changed = true;
+            continue;
+        }
+        if (!result.empty() && result.back().quantifier == block.quantifier) {
+            result.back().vars.insert(result.back().vars.end(), block.vars.begin(), block.vars.end());
+            changed = true;
+            continue;
+        }
+        result.push_back(std::move(block));
+    }
+    prefix = std::move(result);
+    return changed;
+}
+
+std::vector<Component> splitComponents(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix) {
+    std::vector<Component> components;
+    int n = std::max(matrix.maxVar(), maxPrefixVar(prefix));
+
+    // 1. 同一子句中的變數併入同一集合
+    std::vector<int> parent(n + 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const auto& clause : matrix) {
+        if (clause.empty()) continue;
+        int root = findRoot(parent, std::abs(clause[0]));
+        for (int lit : clause) {
+            int other = findRoot(parent, std::abs(lit));
+            if (other != root) parent[other] = root;
+        }
+    }
+
+    // 2. 每個子句歸入其變數所屬的分量 (空子句自成一個分量)
+    std::vector<int> comp_of_root(n + 1, -1);
+    std::vector<int> clause_comp(matrix.size());
+    int num_comps = 0;
+    for (size_t i = 0; i < matrix.size(); i++) {
+        ClauseDB::Clause clause = matrix[i];
+        if (clause.empty()) {
+            clause_comp[i] = num_comps++;
+            continue;
+        }
+        int root = findRoot(parent, std::abs(clause[0]));
+        if (comp_of_root[root] < 0) comp_of_root[root] = num_comps++;
+        clause_comp[i] = comp_of_root[root];
+    }
+    if (num_comps <= 1) return components;
+
+    // 3. 分別複製子句與 prefix
+    components.resize(num_comps);
+    for (size_t i = 0; i < matrix.size(); i++) {
+        Component& comp = components[clause_comp[i]];
+        for (int lit : matrix[i]) comp.matrix.addLiteral(lit);
+        comp.matrix.endClause();
+    }
+    for (const auto& block : prefix) {
+        for (auto& comp : components) comp.prefix.push_back({block.quantifier, {}});
+        for (int var : block.vars) {
+            int root = findRoot(parent, var);
+            if (comp_of_root[root] < 0) continue; // 不在任何子句中
+            components[comp_of_root[root]].prefix.back().vars.push_back(var);
+        }
+    }
+    for (auto& comp : components) normalizePrefix(comp.prefix, comp.matrix);
+
+    std::stable_sort(components.begin(), components.end(), [](const Component& a, const Component& b) {
+        return a.matrix.size() < b.matrix.size();
+    });
+    return components;
+}
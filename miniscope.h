@@ -0,0 +1,26 @@
+#ifndef MINISCOPE_H
+#define MINISCOPE_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <vector>
+
+// prefix 正規化：移除不在 matrix 中的變數、移除空區塊、合併相鄰的同量詞區塊。
+// 回傳是否有任何變動。
+bool normalizePrefix(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix);
+
+// 只移除空區塊、合併相鄰的同量詞區塊，保留所有變數 (增量求解之後還可能用到)
+bool mergeBlocks(std::vector<QBFSolver::Formula>& prefix);
+
+// Miniscoping：變數互不相交的子句群彼此獨立，
+// 原 QBF 為真若且唯若每一個子 QBF 皆為真。
+struct Component {
+    std::vector<QBFSolver::Formula> prefix; // 已正規化
+    ClauseDB matrix;
+};
+
+// 依變數的連通性把 (prefix, matrix) 切成獨立的子問題，依子句數由小到大排列。
+// 只有一個連通分量時回傳空集合 (呼叫端直接使用原公式)。
+std::vector<Component> splitComponents(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix);
+
+#endif
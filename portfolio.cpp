@@ -0,0 +1,107 @@
+#include "portfolio.h"
+#include <atomic>
+#include <thread>
+
+std::vector<Portfolio::Config> Portfolio::defaultConfigs(int n, const QBFSolver::Options& base) {
+    // 每個設定以 4 個維度描述：前處理、最小化、XOR 模式 (0 XOR+Gauss, 1 XOR 無 Gauss, 2 無 XOR)、polarity。
+    // 先放幾個差異最大的組合，之後依序列出其餘組合。
+    struct Variant {
+        bool preprocess, minimize;
+        int xor_mode;
+        bool polarity;
+    };
+    std::vector<Variant> variants = {
+        {true, true, 0, false},
+        {true, true, 0, true},
+        {false, true, 0, false},
+        {true, false, 0, false},
+        {true, true, 1, false},
+        {true, true, 2, false},
+        {false, true, 2, true},
+        {true, false, 2, true},
+    };
+    for (int bits = 0; bits < 24; bits++) {
+        Variant v = {(bits & 1) == 0, (bits & 2) == 0, bits / 8, (bits & 4) != 0};
+        bool seen = false;
+        for (const Variant& u : variants) {
+            if (u.preprocess == v.preprocess && u.minimize == v.minimize && u.xor_mode == v.xor_mode && u.polarity == v.polarity) seen = true;
+        }
+        if (!seen) variants.push_back(v);
+    }
+
+    std::vector<Config> configs;
+    for (int i = 0; i < n && i < (int)variants.size(); i++) {
+        const Variant& v = variants[i];
+        Config config;
+        config.options = base;
+        config.options.component_threads = 1;
+        if (!v.preprocess) config.options.preprocess = false;
+        if (!v.minimize) config.options.minimize_refinement = false;
+        if (v.xor_mode == 1) config.options.gauss = false;
+        if (v.xor_mode == 2) config.options.use_xor = false;
+        if (v.polarity) config.options.polarity = 1;
+        config.options.seed = base.seed + i;
+        if (i % 3 == 1) config.options.restart = R_LUBY;
+        if (i % 3 == 2) config.options.restart = R_GEOMETRIC;
+
+        std::string name;
+        auto add = [&](const char* part) {
+            if (!name.empty()) name += '+';
+            name += part;
+        };
+        if (!v.preprocess) add("no-preprocess");
+        if (!v.minimize) add("no-minimize");
+        if (v.xor_mode == 1) add("no-gauss");
+        if (v.xor_mode == 2) add("no-xor");
+        if (v.polarity) add("polarity-true");
+        if (i % 3 == 1) add("luby");
+        if (i % 3 == 2) add("geometric");
+        config.name = name.empty() ? "default" : name;
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+Portfolio::Portfolio(std::vector<Config> configs) : configs(std::move(configs)) {
+    makeSolvers();
+}
+
+void Portfolio::makeSolvers() {
+    solvers.clear();
+    for (const Config& config : configs) {
+        solvers.push_back(std::make_unique<QBFSolver>());
+        solvers.back()->options = config.options;
+    }
+}
+
+void Portfolio::interrupt() {
+    for (auto& solver : solvers) solver->interrupt();
+}
+
+QBFResult Portfolio::solve(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix) {
+    if (used) makeSolvers();
+    used = true;
+    winner_index = -1;
+
+    std::atomic<int> winner{-1};
+    QBFResult result = Q_UNKNOWN;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < (int)solvers.size(); i++) {
+        workers.emplace_back([&, i]() {
+            // prefix 很小，各自複製一份；matrix 共用
+            std::vector<QBFSolver::Formula> own_prefix = prefix;
+            QBFResult res = solvers[i]->solve(own_prefix, matrix);
+            if (res == Q_UNKNOWN) return;
+            int expected = -1;
+            if (!winner.compare_exchange_strong(expected, i)) return;
+            result = res;
+            for (int j = 0; j < (int)solvers.size(); j++) {
+                if (j != i) solvers[j]->interrupt();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    winner_index = winner;
+    return result;
+}
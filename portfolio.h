@@ -0,0 +1,53 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Portfolio 模式：多個設定不同的 QBFSolver 在各自的 thread 上同時求解同一個公式。
+// matrix 由所有 solver 唯讀共用；最先得到 SAT / UNSAT 的設定勝出，
+// 其餘的 solver 以 QBFSolver::interrupt 要求停止 (cooperative)。
+class Portfolio {
+public:
+    struct Config {
+        std::string name;
+        QBFSolver::Options options;
+    };
+
+    // 以 base 為基礎，依序變化 前處理、refinement 最小化、XOR / Gauss-Jordan 與 polarity，
+    // 回傳前 n 個互不相同的設定 (最多 24 個)。CMS 的 seed 依序為 base.seed + i，
+    // restart 策略輪流使用 base 的設定、luby 與 geometric，設定相近的成員也會走不同的搜尋路徑
+    static std::vector<Config> defaultConfigs(int n, const QBFSolver::Options& base);
+
+    explicit Portfolio(std::vector<Config> configs);
+
+    // 沒有設定得到答案時回傳 Q_UNKNOWN：每個設定都用完了 time_limit / conflict_limit，或被 interrupt
+    QBFResult solve(const std::vector<QBFSolver::Formula>& prefix, const ClauseDB& matrix);
+
+    // 要求所有設定停下 (QBFSolver::interrupt)，solve 在 worker 都結束後回傳。
+    // 可由其他 thread 或 signal handler 呼叫 (只寫 atomic)，但不能與 solve 的開始 (重建 solver) 同時
+    void interrupt();
+
+    // 各設定的 solver 在建構時就建立，求解中也可以讀取 (例如 SIGINT 時輸出統計)。
+    // 再次呼叫 solve 時會換成新的 solver
+    int size() const { return solvers.size(); }
+    const QBFSolver& solver(int i) const { return *solvers[i]; }
+
+    // 勝出的設定，solve 之後才有意義；沒有勝出者時為 -1
+    int winner() const { return winner_index; }
+    const Config& winnerConfig() const { return configs[winner_index]; }
+    const QBFSolver& winnerSolver() const { return *solvers[winner_index]; }
+
+private:
+    std::vector<Config> configs;
+    std::vector<std::unique_ptr<QBFSolver>> solvers;
+    int winner_index = -1;
+    bool used = false; // solvers 已經求解過 (被中斷的 solver 不能再用)
+
+    void makeSolvers();
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "preprocess.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+PreprocessResult Preprocessor::run(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& in, ClauseDB& out) {
+    auto start_time = std::chrono::steady_clock::now();
+    st = Stats();
+    conflict = false;
+    units.clear();
+    pure_queue.clear();
+    bce_left = options.bce_budget;
+
+    // 1. 變數資訊
+    int n = in.maxVar();
+    for (const auto& block : prefix) {
+        for (int var : block.vars) n = std::max(n, var);
+    }
+    level.assign(n + 1, -1);
+    quantifier.assign(n + 1, 'e');
+    value.assign(n + 1, 0);
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        for (int var : prefix[depth].vars) {
+            level[var] = depth;
+            quantifier[var] = prefix[depth].quantifier;
+        }
+    }
+
+    // 2. 複製子句，去除重複文字與恆真子句
+    int num_clauses = in.size();
+    lits.clear();
+    lits.reserve(in.numLiterals());
+    start.assign(num_clauses, 0);
+    len.assign(num_clauses, 0);
+    alive.assign(num_clauses, 1);
+    std::vector<int> seen(2 * n + 2, -1);
+    std::vector<char> occurs(n + 1, 0);
+    for (int c = 0; c < num_clauses; c++) {
+        start[c] = lits.size();
+        for (int lit : in[c]) {
+            if (seen[litIndex(lit)] == c) continue;
+            if (seen[litIndex(-lit)] == c) alive[c] = 0;
+            seen[litIndex(lit)] = c;
+            lits.push_back(lit);
+            occurs[std::abs(lit)] = 1;
+        }
+        len[c] = lits.size() - start[c];
+        if (!alive[c]) st.tautologies++;
+    }
+    st.clauses_before = num_clauses;
+    st.vars_before = std::count(occurs.begin(), occurs.end(), 1);
+
+    // 3. 出現表
+    count.assign(2 * n + 2, 0);
+    for (int c = 0; c < num_clauses; c++) {
+        if (!alive[c]) continue;
+        for (size_t j = start[c]; j < start[c] + len[c]; j++) count[litIndex(lits[j])]++;
+    }
+    occ_start.assign(2 * n + 3, 0);
+    for (int idx = 0; idx < 2 * n + 2; idx++) occ_start[idx + 1] = occ_start[idx] + count[idx];
+    occ.assign(occ_start.back(), 0);
+    std::vector<size_t> fill(occ_start.begin(), occ_start.end() - 1);
+    for (int c = 0; c < num_clauses; c++) {
+        if (!alive[c]) continue;
+        for (size_t j = start[c]; j < start[c] + len[c]; j++) occ[fill[litIndex(lits[j])]++] = c;
+    }
+
+    // 4. 先對每個子句做 universal reduction，再反覆套用各項技術直到不動點
+    for (int c = 0; c < num_clauses && !conflict; c++) {
+        if (!alive[c]) continue;
+        reduce(c);
+        check(c);
+    }
+    for (int var = 1; var <= n; var++) pure_queue.push_back(var);
+
+    while (!conflict) {
+        propagate();
+        if (conflict) break;
+        if (options.pure_literals && eliminatePure()) continue;
+        if (options.blocked_clauses && eliminateBlocked()) continue;
+        break;
+    }
+
+    // 5. 輸出剩下的子句與用到的變數
+    out.clear();
+    std::fill(occurs.begin(), occurs.end(), 0);
+    if (!conflict) {
+        for (int c = 0; c < num_clauses; c++) {
+            if (!alive[c]) continue;
+            st.clauses_after++;
+            for (size_t j = start[c]; j < start[c] + len[c]; j++) {
+                out.addLiteral(lits[j]);
+                occurs[std::abs(lits[j])] = 1;
+            }
+            out.endClause();
+        }
+    }
+    for (auto& block : prefix) {
+        block.vars.erase(std::remove_if(block.vars.begin(), block.vars.end(), [&](int var) { return !occurs[var]; }), block.vars.end());
+        st.vars_after += block.vars.size();
+    }
+
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (conflict) return P_UNSAT;
+    if (out.empty()) return P_SAT;
+    return P_UNDECIDED;
+}
+
+// 刪除整個子句，更新出現次數
+void Preprocessor::removeClause(int c) {
+    alive[c] = 0;
+    for (size_t j = start[c]; j < start[c] + len[c]; j++) {
+        int idx = litIndex(lits[j]);
+        if (--count[idx] == 0) pure_queue.push_back(std::abs(lits[j]));
+    }
+}
+
+// 從子句 c 刪除文字 lit；子句中沒有這個文字時回傳 false
+bool Preprocessor::removeLiteral(int c, int lit) {
+    size_t first = start[c], last = start[c] + len[c];
+    for (size_t j = first; j < last; j++) {
+        if (lits[j] != lit) continue;
+        lits[j] = lits[last - 1];
+        len[c]--;
+        if (--count[litIndex(lit)] == 0) pure_queue.push_back(std::abs(lit));
+        return true;
+    }
+    return false;
+}
+
+// Universal reduction：比子句中所有 ∃ 文字都內層的 ∀ 文字可以直接刪掉
+void Preprocessor::reduce(int c) {
+    if (!options.universal_reduction) return;
+    int max_e = -2;
+    for (size_t j = start[c]; j < start[c] + len[c]; j++) {
+        int var = std::abs(lits[j]);
+        if (!isUniversal(var)) max_e = std::max(max_e, level[var]);
+    }
+    for (size_t j = start[c]; j < start[c] + len[c];) {
+        int var = std::abs(lits[j]);
+        if (isUniversal(var) && level[var] > max_e) {
+            removeLiteral(c, lits[j]);
+            st.reduced_literals++;
+        } else {
+            j++;
+        }
+    }
+}
+
+// 子句變短之後：空子句 -> UNSAT，單位子句 -> 排入 propagate
+void Preprocessor::check(int c) {
+    if (len[c] == 0) {
+        conflict = true;
+        return;
+    }
+    if (len[c] != 1) return;
+    int lit = lits[start[c]];
+    // 只剩 ∀ 文字的子句，∀ 一定能讓它為假
+    if (isUniversal(std::abs(lit))) {
+        conflict = true;
+        return;
+    }
+    if (options.unit_propagation) units.push_back(lit);
+}
+
+// 令 lit 為真：滿足的子句刪除，含 -lit 的子句縮短
+void Preprocessor::assign(int lit) {
+    int var = std::abs(lit);
+    if (value[var] != 0) {
+        if ((value[var] > 0) != (lit > 0)) conflict = true;
+        return;
+    }
+    value[var] = (lit > 0) ? 1 : -1;
+
+    int idx = litIndex(lit);
+    for (size_t k = occ_start[idx]; k < occ_start[idx + 1]; k++) {
+        int c = occ[k];
+        if (!alive[c]) continue;
+        // 出現表不會隨文字刪除更新，需確認子句仍含有 lit
+        bool contains = false;
+        for (size_t j = start[c]; j < start[c] + len[c]; j++) {
+            if (lits[j] == lit) {
+                contains = true;
+                break;
+            }
+        }
+        if (contains) removeClause(c);
+    }
+    idx = litIndex(-lit);
+    for (size_t k = occ_start[idx]; k < occ_start[idx + 1] && !conflict; k++) {
+        int c = occ[k];
+        if (!alive[c] || !removeLiteral(c, -lit)) continue;
+        reduce(c);
+        check(c);
+    }
+}
+
+void Preprocessor::propagate() {
+    while (!units.empty() && !conflict) {
+        int lit = units.back();
+        units.pop_back();
+        if (value[std::abs(lit)] == 0) st.units++;
+        assign(lit);
+    }
+}
+
+// 只以單一極性出現的變數：∃ 令其為真，∀ 令其為假
+bool Preprocessor::eliminatePure() {
+    bool changed = false;
+    while (!pure_queue.empty() && !conflict) {
+        int var = pure_queue.back();
+        pure_queue.pop_back();
+        if (value[var] != 0) continue;
+        int pos = count[litIndex(var)], neg = count[litIndex(-var)];
+        if ((pos == 0) == (neg == 0)) continue;
+        int lit = (pos > 0) ? var : -var;
+        assign(isUniversal(var) ? -lit : lit);
+        st.pure_literals++;
+        changed = true;
+        propagate();
+    }
+    return changed;
+}
+
+// QBCE：子句 c 對 ∃ 文字 lit 被阻擋 (blocked)，若每個含 -lit 的子句 d
+// 與 c 的 resolvent 都在某個不比 lit 內層的變數上恆真
+bool Preprocessor::isBlocked(int c, int lit, std::vector<int>& mark, int stamp, long long& budget) {
+    int idx = litIndex(-lit);
+    for (size_t k = occ_start[idx]; k < occ_start[idx + 1]; k++) {
+        int d = occ[k];
+        if (!alive[d] || d == c) continue;
+        bool has_lit = false, tautology = false;
+        for (size_t j = start[d]; j < start[d] + len[d]; j++) {
+            int other = lits[j];
+            if (other == -lit) {
+                has_lit = true;
+                continue;
+            }
+            if (mark[litIndex(-other)] == stamp && level[std::abs(other)] <= level[std::abs(lit)]) tautology = true;
+        }
+        budget -= len[d];
+        if (has_lit && !tautology) return false;
+    }
+    return true;
+}
+
+bool Preprocessor::eliminateBlocked() {
+    long long& budget = bce_left;
+    int removed = 0;
+    std::vector<int> mark(count.size(), 0);
+    int stamp = 0;
+    for (int c = 0; c < (int)len.size() && budget > 0; c++) {
+        if (!alive[c]) continue;
+        stamp++;
+        for (size_t j = start[c]; j < start[c] + len[c]; j++) mark[litIndex(lits[j])] = stamp;
+        for (size_t j = start[c]; j < start[c] + len[c]; j++) {
+            int lit = lits[j];
+            if (isUniversal(std::abs(lit))) continue;
+            if (isBlocked(c, lit, mark, stamp, budget)) {
+                removeClause(c);
+                removed++;
+                break;
+            }
+        }
+    }
+    st.blocked_clauses += removed;
+    return removed > 0;
+}
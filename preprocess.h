@@ -0,0 +1,86 @@
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <cstdlib>
+#include <vector>
+
+enum PreprocessResult { P_UNDECIDED, P_SAT, P_UNSAT };
+
+// CEGAR 之前的 QBF 前處理 (bloqqer 風格)：
+//   universal reduction、unit propagation、pure literal elimination、
+//   quantified blocked clause elimination (QBCE)
+// 各項技術可分別開關；只刪除子句或文字，不會新增。
+class Preprocessor {
+public:
+    struct Options {
+        bool universal_reduction = true;
+        bool unit_propagation = true;
+        bool pure_literals = true;
+        bool blocked_clauses = true;
+        long long bce_budget = 50000000; // QBCE 最多檢查的文字數
+    };
+
+    struct Stats {
+        int clauses_before = 0;
+        int clauses_after = 0;
+        int vars_before = 0;
+        int vars_after = 0;
+        int tautologies = 0;
+        int reduced_literals = 0;   // universal reduction 刪掉的文字
+        int units = 0;
+        int pure_literals = 0;
+        int blocked_clauses = 0;
+        double seconds = 0;
+    };
+
+    explicit Preprocessor(const Options& options) : options(options) {}
+
+    // 化簡 (prefix, in)，結果寫進 prefix 與 out。
+    // 已決定真假時回傳 P_SAT / P_UNSAT，此時 out 的內容無意義。
+    // 被賦值或不再出現的變數會從 prefix 中移除 (可能留下空區塊)。
+    PreprocessResult run(std::vector<QBFSolver::Formula>& prefix, const ClauseDB& in, ClauseDB& out);
+
+    const Stats& stats() const { return st; }
+
+private:
+    Options options;
+    Stats st;
+
+    // 變數資訊 (以變數編號索引)
+    std::vector<int> level;
+    std::vector<char> quantifier;
+    std::vector<signed char> value;     // 0 未賦值，1 為真，-1 為假
+
+    // 可修改的子句：文字存在 lits[start[c] .. start[c]+len[c])，只會縮短
+    std::vector<int> lits;
+    std::vector<size_t> start;
+    std::vector<int> len;
+    std::vector<char> alive;
+
+    // 出現表 (CSR，以文字索引)，刪除文字時不更新，使用時再檢查
+    std::vector<size_t> occ_start;
+    std::vector<int> occ;
+    std::vector<int> count;             // 每個文字目前出現在幾個有效子句中
+
+    std::vector<int> units;             // 待處理的單位子句
+    std::vector<int> pure_queue;        // 出現次數有變化、需重新檢查純文字的變數
+    bool conflict = false;
+    long long bce_left = 0;             // QBCE 剩下的預算，跨回合共用
+
+    static int litIndex(int lit) { return 2 * std::abs(lit) + (lit < 0); }
+    bool isUniversal(int var) const { return quantifier[var] == 'a'; }
+
+    void removeClause(int c);
+    bool removeLiteral(int c, int lit);
+    void reduce(int c);
+    void check(int c);
+    void assign(int lit);
+    void propagate();
+    bool eliminatePure();
+    bool eliminateBlocked();
+    bool isBlocked(int c, int lit, std::vector<int>& mark, int stamp, long long& budget);
+};
+
+#endif
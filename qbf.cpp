@@ -1,223 +1,875 @@
 #include "qbf.h"
+#include "dependency.h"
+#include "log.h"
+#include "miniscope.h"
+#include "preprocess.h"
+#include "xor_finder.h"
 #include <cmath>
 #include <algorithm>
-#include <iostream>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
 
-// 公開介面：呼叫遞迴起始點
-QBFResult QBFSolver::solve(std::vector<Formula>& prefix, std::vector<std::vector<int>> matrix) {
-    int number_of_clauses = matrix.size();
+// 公開介面：計時並重設統計
+QBFResult QBFSolver::solve(std::vector<Formula>& prefix, const ClauseDB& matrix) {
+    start_time = std::chrono::steady_clock::now();
+    st = Stats();
+    st.clauses_before = matrix.size();
+    startBudget();
+    QBFResult res = solvePipeline(prefix, matrix);
+    stopBudget();
+    st.seconds = elapsedSeconds(start_time);
+    return res;
+}
 
-    int max_ID = 1;
-    for(const auto& clause : matrix){
-        for(int lit : clause){
-            if(abs(lit)> max_ID){
-                max_ID = abs(lit);
-            }
+// 前處理、正規化與 miniscoping 後交給 CEGAR (solveLevels)
+QBFResult QBFSolver::solvePipeline(std::vector<Formula>& prefix, const ClauseDB& matrix) {
+    work_prefix = prefix;
+    const ClauseDB* formula = &matrix;
+
+    if (options.preprocess) {
+        Preprocessor::Options pre_options;
+        pre_options.universal_reduction = options.universal_reduction;
+        pre_options.unit_propagation = options.unit_propagation;
+        pre_options.pure_literals = options.pure_literals;
+        pre_options.blocked_clauses = options.blocked_clauses;
+        Preprocessor pre(pre_options);
+
+        PreprocessResult pre_res = pre.run(work_prefix, matrix, work_matrix);
+
+        const Preprocessor::Stats& pre_st = pre.stats();
+        LOG_INFO("preprocess : clauses " << pre_st.clauses_before << " -> " << pre_st.clauses_after
+                 << ", vars " << pre_st.vars_before << " -> " << pre_st.vars_after
+                 << " (tautologies " << pre_st.tautologies << ", reduced literals " << pre_st.reduced_literals
+                 << ", units " << pre_st.units << ", pure " << pre_st.pure_literals
+                 << ", blocked " << pre_st.blocked_clauses << ", " << pre_st.seconds << " s)");
+        st.preprocess_seconds = pre_st.seconds;
+        st.clauses_after = pre_st.clauses_after;
+
+        if (pre_res == P_SAT) return Q_SAT;
+        if (pre_res == P_UNSAT) return Q_UNSAT;
+        formula = &work_matrix;
+    }
+
+    // 每多一層就多一個 level 與一個抽象 solver，先把 prefix 壓到最淺
+    int blocks_before = work_prefix.size();
+    normalizePrefix(work_prefix, *formula);
+    if ((int)work_prefix.size() != blocks_before) {
+        LOG_INFO("normalize : blocks " << blocks_before << " -> " << (int)work_prefix.size());
+    }
+
+    // 真正的依賴關係通常比線性 prefix 少：刪掉不被依賴的 ∀ 文字，並把變數往外層移
+    if (options.dependencies && work_prefix.size() > 1) {
+        DependencyAnalysis::Options dep_options;
+        dep_options.reduce = options.universal_reduction;
+        DependencyAnalysis dep(dep_options);
+        dep.run(work_prefix, *formula, reduced_matrix);
+        formula = &reduced_matrix;
+
+        const DependencyAnalysis::Stats& dep_st = dep.stats();
+        LOG_INFO("dependencies : blocks " << dep_st.blocks_before << " -> " << dep_st.blocks_after
+                 << ", moved vars " << dep_st.moved_vars << ", reduced literals " << dep_st.reduced_literals
+                 << (dep_st.reduce_skipped ? " (reduction skipped, budget)" : "") << ", " << dep_st.seconds << " s");
+        if (dep_st.reduced_literals > 0) normalizePrefix(work_prefix, *formula);
+    }
+    st.clauses_after = formula->size();
+    st.prefix_blocks = work_prefix.size();
+
+    if (options.miniscope) {
+        std::vector<Component> components = splitComponents(work_prefix, *formula);
+        if (!components.empty()) return solveComponents(components);
+    }
+    return solveFormula(work_prefix, *formula);
+}
+
+// 各個子 QBF 互相獨立，全部為真時原公式才為真；遇到 UNSAT 即可停止。
+// 每個子問題使用自己的 QBFSolver，因此可以放在不同的 thread 上求解。
+QBFResult QBFSolver::solveComponents(std::vector<Component>& components) {
+    LOG_INFO("miniscope : " << (int)components.size() << " components");
+    st.components = components.size();
+
+    Options sub_options = options;
+    sub_options.preprocess = false; // 已經做過
+    sub_options.miniscope = false;
+    std::mutex stats_mutex;
+    auto solveOne = [&](Component& comp) {
+        // 子問題共用 interrupt_state：deadline 與 timer 都是這次查詢的，子問題不重設
+        QBFSolver sub;
+        sub.options = sub_options;
+        sub.interrupt_state = interrupt_state;
+        sub.owns_budget = false;
+        QBFResult res = sub.solve(comp.prefix, comp.matrix);
+        std::lock_guard<std::mutex> guard(stats_mutex);
+        st.merge(sub.stats());
+        return res;
+    };
+
+    int num_threads = std::min<int>(options.component_threads, components.size());
+    if (num_threads <= 1) {
+        // 子問題已依大小排序，小的先解，較早碰到 UNSAT
+        for (Component& comp : components) {
+            QBFResult res = solveOne(comp);
+            if (res != Q_SAT) return res;
         }
+        return Q_SAT;
     }
 
-    std::cout << "max_ID :" << max_ID <<std::endl;
-    std::cout << "prefix size :" << (int)prefix.size() <<std::endl;
+    // 多 thread：每個 worker 依序領取下一個子問題；有人得到 UNSAT 後不再領取新的
+    std::atomic<size_t> next{0};
+    std::atomic<bool> unsat{false};
+    std::atomic<bool> unknown{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) {
+        workers.emplace_back([&]() {
+            while (!unsat && !unknown) {
+                size_t i = next++;
+                if (i >= components.size()) break;
+                QBFResult res = solveOne(components[i]);
+                if (res == Q_UNSAT) unsat = true;
+                if (res == Q_UNKNOWN) unknown = true;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    if (unsat) return Q_UNSAT;
+    return unknown ? Q_UNKNOWN : Q_SAT;
+}
+
+// 以 CEGAR 求解 (prefix, matrix)
+QBFResult QBFSolver::solveFormula(std::vector<Formula>& prefix, const ClauseDB& matrix) {
+    incremental = false;
+    selector_stride = 2;
+
+    int max_ID = maxVarOf(prefix, matrix);
+    LOG_INFO("max_ID :" << max_ID);
+    LOG_INFO("prefix size :" << (int)prefix.size());
+
+    buildVarTable(prefix, max_ID);
+    initLevelStats(prefix);
+
+    // 兩個量詞區塊：改用專門的 2QBF 引擎 (two_qbf.cpp)
+    if (options.two_qbf && prefix.size() == 2) return solve2QBF(prefix, matrix, max_ID);
+
+    buildAbstraction(prefix, matrix, max_ID);
+    if (levels.empty()) return matrix.empty() ? Q_SAT : Q_UNSAT;
 
     // return Q_SAT;
-    return solve_recursive(prefix, 0, matrix, ++max_ID);
+    return solveLevels(prefix);
 }
 
-// 核心 CEGAR 遞迴邏輯
-QBFResult QBFSolver::solve_recursive(const std::vector<Formula>& prefix, int depth, std::vector<std::vector<int>> matrix, int next_ID) {
-    // 1. 基底情況 (Base Cases)
-    // 若矩陣為空，代表所有子句皆已滿足 -> SAT
-    if (matrix.empty()) return Q_SAT;
-    std::cout << "depth" << depth << std::endl;
+// matrix 與 prefix 中最大的變數編號 (prefix 可能含有未出現在 matrix 中的變數，例如 QDIMACS 的自由變數)
+int QBFSolver::maxVarOf(const std::vector<Formula>& prefix, const ClauseDB& matrix) {
+    int max_ID = std::max(1, matrix.maxVar());
+    for(const auto& block : prefix){
+        for(int var : block.vars){
+            if(var > max_ID){
+                max_ID = var;
+            }
+        }
+    }
+    return max_ID;
+}
 
-    // 若矩陣中包含空子句 (代表出現了 False) -> UNSAT
-    // for (const auto& c : matrix) {
-    //     if (c.empty()) {
-    //         std::cout << "empty clause" <<std::endl;
-    //         return Q_UNSAT;
-    //     }
-    // }
+void QBFSolver::initLevelStats(const std::vector<Formula>& prefix) {
+    st.levels.assign(prefix.size(), LevelStats());
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        st.levels[depth].quantifier = prefix[depth].quantifier;
+        st.levels[depth].vars = prefix[depth].vars.size();
+    }
+}
 
-    for (size_t i = 0; i < matrix.size(); i++) {
-        if (matrix[i].empty()) {
-            std::cout << "Empty clause found at index: " << i << std::endl;
-            return Q_UNSAT;
+// 建立各層的抽象，並讓所有子句在最外層有效。
+// 每一層的抽象只建立一次，之後的 CEGAR 迭代都在 assumption 下重複使用
+void QBFSolver::buildAbstraction(const std::vector<Formula>& prefix, const ClauseDB& matrix, int max_ID) {
+    this->matrix = &matrix;
+    selector_base = max_ID + 1;
+
+    // clause_depth：子句中最內層的文字所在層數
+    clause_depth.assign(matrix.size(), -1);
+    int i = 0;
+    for (const auto& clause : matrix) {
+        for (int lit : clause) {
+            clause_depth[i] = std::max(clause_depth[i], levelOf(std::abs(lit)));
         }
+        i += 1;
+    }
+
+    // 由外往內分組：group_of[i] 為子句 i 在上一層所屬的群組
+    levels.clear();
+    std::vector<int> group_of(matrix.size(), -1);
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        buildLevel(prefix, depth, group_of);
     }
 
+    if (options.use_xor) addXors(matrix);
+
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        st.levels[depth].peak_clauses = levels[depth]->alpha.numClauses();
+    }
+
+    // 分組表之後只有增量模式 (addClause) 會用到
+    for (int depth = 0; depth < (int)levels.size(); depth++) {
+        st.levels[depth].groups = levels[depth]->rep.size();
+        if (!incremental) levels[depth]->group_index = {};
+    }
+
+    // 最外層：所有群組都有效
+    if (levels.empty()) return;
+    for (int g = 0; g < (int)levels[0]->rep.size(); g++) setActive(0, g, true);
+}
+
+// 建立 變數 -> (層數, 量詞) 的對照表，之後的成員判斷都是一次陣列讀取
+void QBFSolver::buildVarTable(const std::vector<Formula>& prefix, int max_ID) {
+    var_info.assign(max_ID + 1, VarInfo{-1, 'e'});
+    for (int depth = 0; depth < (int)prefix.size(); depth++) {
+        for (int var : prefix[depth].vars) {
+            var_info[var] = VarInfo{depth, prefix[depth].quantifier};
+        }
+    }
+}
+
+// 把 matrix 中的 XOR 交給對應層的抽象。
+// XOR 的變數全部屬於同一個 ∃ 區塊 d 時，外層無法滿足這些子句，
+// 它們在第 d 層一定要被滿足 (或交給內層後變成空子句)，因此可以無條件加到第 d 層。
+// 跨越多個區塊或含 ∀ 變數的 XOR 維持 CNF 形式。
+void QBFSolver::addXors(const ClauseDB& matrix) {
+    std::vector<XorConstraint> xors = findXors(matrix, options.max_xor_size);
+    int placed = 0;
+    for (const XorConstraint& x : xors) {
+        int depth = levelOf(x.vars[0]);
+        bool same_level = (depth >= 0 && quantifierOf(x.vars[0]) == 'e');
+        for (int var : x.vars) {
+            if (levelOf(var) != depth) same_level = false;
+        }
+        if (!same_level) continue;
+
+        SATSolver& alpha = levels[depth]->alpha;
+        if (options.gauss && !levels[depth]->has_xor) alpha.enableGauss();
+        levels[depth]->has_xor = true;
+        alpha.addXorClause(x.vars, x.rhs);
+        placed++;
+    }
+    LOG_INFO("xor found :" << (int)xors.size() << " placed :" << placed);
+}
+
+// 建立第 depth 層的抽象 (Abstraction)：每個子句找到 (或建立) 本層的群組
+void QBFSolver::buildLevel(const std::vector<Formula>& prefix, int depth, std::vector<int>& group_of) {
+    levels.push_back(std::make_unique<Level>(&interrupt_state->cms, options.small_sat_vars, satConfig()));
+    Level& level = *levels.back();
+    level.quantifier = prefix[depth].quantifier;
+    level.is_last = (depth >= (int)prefix.size() - 1);
+    if (!level.is_last) level.vars_of_interest = prefix[depth].vars;
+
+    for (int i = 0; i < (int)group_of.size(); i++) group_of[i] = groupOf(depth, group_of[i], i);
+
+    // 最後一層：∀ 只要讓任一個有效群組為假即可
+    if (level.is_last && level.quantifier == 'a') addLeafCover(depth);
+}
+
+// 子句 clause 在第 depth 層的群組 (parent 為它在外層的群組)。
+// 外層群組相同、同樣有或沒有更內層的文字、本層投影也相同的子句共用一個群組；沒有時建立新的群組
+int QBFSolver::groupOf(int depth, int parent, int clause) {
+    Level& level = *levels[depth];
+    std::vector<int>& key = level.key;
+    key.clear();
+    key.push_back(parent);
+    key.push_back(clause_depth[clause] > depth);
+    for (int lit : (*matrix)[clause]) {
+        if (levelOf(std::abs(lit)) == depth) key.push_back(lit);
+    }
+    std::sort(key.begin() + 2, key.end());
+    key.erase(std::unique(key.begin() + 2, key.end()), key.end());
+
+    auto found = level.group_index.emplace(key, (int)level.rep.size());
+    if (found.second) addGroupToLevel(depth, parent, clause);
+    return found.first->second;
+}
+
+// 以子句 clause 為代表，在第 depth 層加入一個新群組 (本層投影取自 level.key)：
+// 選擇變數、assumption 與抽象中的子句。
+// 群組依編號順序加入；var_b / var_act 以 selector_stride 交錯編號，之後可以繼續往後加
+void QBFSolver::addGroupToLevel(int depth, int parent, int clause) {
+    Level& level = *levels[depth];
+    SATSolver& alpha = level.alpha;
+    int b = selector_base + selector_stride * (int)level.rep.size();
+    int act = b + 1;
+    level.parent.push_back(parent);
+    level.rep.push_back(clause);
+    if ((int)level.active_bits.size() * 32 < (int)level.rep.size()) level.active_bits.push_back(0);
+    level.dead.push_back(clause_depth[clause] < depth);
+    level.var_act.push_back(act);
+    level.assumptions.push_back(-act);
+
+    std::vector<int> clause_p(level.key.begin() + 2, level.key.end());
+    level.touches.push_back(!clause_p.empty());
+
+    // 不含本層文字的群組：∃ 無法在本層滿足它，∀ 把它交給內層也只會更有利，
+    // 有效時一定整組交下去，因此不需要自己的 b，直接以 act 代替
+    // (在最後一層即為空子句，由 num_dead 處理，不會進到 alpha)
+    if (clause_p.empty()) {
+        level.var_b.push_back(act);
+        return;
+    }
+    level.var_b.push_back(b);
+    if (!level.is_last) level.vars_of_interest.push_back(b);
+
+    if (level.quantifier == 'e') {
+        // 群組有效時，本層必須滿足它，否則標記 b 交給內層；
+        // 最後一層沒有內層可交付
+        clause_p.push_back(-act);
+        if (!level.is_last) {
+            clause_p.push_back(b);
+            alpha.addClause({-b, act});
+        }
+        alpha.addClause(clause_p);
+    } else {
+        for (int lit : clause_p) alpha.addClause({-lit, -b});
+        // 只有仍然有效的群組才能被交給內層
+        alpha.addClause({-b, act});
+    }
+}
+
+// ∀ 最後一層的覆蓋子句：至少選一個群組讓它為假 (增量模式下以 generation 文字保護)
+void QBFSolver::addLeafCover(int depth) {
+    Level& level = *levels[depth];
+    std::vector<int> cover = level.var_b;
+    if (incremental) cover.push_back(-generationLiteral());
+    level.alpha.addClause(cover);
+}
+
+// 更新第 depth 層的 assumption：群組 group 是否仍有效
+void QBFSolver::setActive(int depth, int group, bool active) {
+    Level& level = *levels[depth];
+    int& lit = level.assumptions[group];
+    if ((lit > 0) == active) return;
+    lit = -lit;
+    level.active_bits[group >> 5] ^= (int)(1u << (group & 31));
+    int delta = active ? 1 : -1;
+    level.num_active += delta;
+    if (level.dead[group]) level.num_dead += delta;
+    if (level.touches[group]) level.num_touching += delta;
+}
+
+// 第 depth 層目前的有效群組之前已有結果時，寫進 res 與 level.core 並回傳 true；
+// 沒有命中時記下來，本層有結果後由 storeResult 加入快取
+bool QBFSolver::lookupResult(int depth, QBFResult& res) {
+    Level& level = *levels[depth];
+    LevelStats& ls = st.levels[depth];
+    if (options.result_cache <= 0) return false;
+    auto found = level.cache.find(level.active_bits);
+    if (found == level.cache.end()) {
+        ls.cache_misses++;
+        level.cache_pending = true;
+        return false;
+    }
+    ls.cache_hits++;
+    res = found->second.res;
+    level.core = found->second.core;
+    return true;
+}
+
+// 第 depth 層這次進入的結果 (res 與 level.core) 加入快取。
+// 超過 options.result_cache 筆時整批清掉，讓最近常出現的有效群組重新進來
+void QBFSolver::storeResult(int depth, QBFResult res) {
+    Level& level = *levels[depth];
+    if (!level.cache_pending) return;
+    level.cache_pending = false;
+    if ((int)level.cache.size() >= options.result_cache) {
+        level.cache.clear();
+        level.cache_bytes = 0;
+    }
+    level.cache.emplace(level.active_bits, Level::CachedResult{res, level.core});
+    // 每筆：節點 (key、結果與兩個指標) 加上 key 與 core 的內容；另外加上 bucket 陣列
+    level.cache_bytes += sizeof(std::pair<const std::vector<int>, Level::CachedResult>) + 2 * sizeof(void*)
+                         + (level.active_bits.size() + level.core.size()) * sizeof(int);
+    LevelStats& ls = st.levels[depth];
+    ls.cache_bytes = std::max(ls.cache_bytes, level.cache_bytes + (long long)(level.cache.bucket_count() * sizeof(void*)));
+}
+
+// 公式改變後，之前的結果不再成立
+void QBFSolver::clearResultCaches() {
+    for (auto& level : levels) {
+        level->cache.clear();
+        level->cache_bytes = 0;
+        level->cache_pending = false;
+    }
+}
+
+// 群組 group 在第 depth 層的投影 (即代表子句的投影) 是否被 model 滿足
+bool QBFSolver::satisfiedAt(int group, int depth, const std::vector<bool>& model) const {
+    for (int lit : (*matrix)[levels[depth]->rep[group]]) {
+        int var = std::abs(lit);
+        if (levelOf(var) == depth && model[var] == (lit > 0)) return true;
+    }
+    return false;
+}
+
+// 內層 (depth + 1) 群組的 core 換成本層的群組：內層群組只屬於一個本層群組，同一個本層群組只記一次
+void QBFSolver::liftCore(int depth, const std::vector<int>& inner_core, std::vector<int>& core) const {
+    const std::vector<int>& parent = levels[depth + 1]->parent;
+    core.clear();
+    for (int g : inner_core) core.push_back(parent[g]);
+    std::sort(core.begin(), core.end());
+    core.erase(std::unique(core.begin(), core.end()), core.end());
+}
+
+// 由本層 alpha 的 failed assumptions 取出 core：
+// active 為 true 時取假設為有效的群組，否則取假設為無效的群組
+void QBFSolver::coreFromConflict(int depth, bool active) {
+    Level& level = *levels[depth];
+    if (!options.minimize_refinement) {
+        coreAll(depth, active);
+        return;
+    }
+    level.core.clear();
+    level.alpha.failedAssumptions(level.failed);
+    for (int lit : level.failed) {
+        if ((lit > 0) != active) continue;
+        // var_act 是等距編號，可直接換算回群組編號；其他 assumption (最外層文字、generation) 略過
+        int offset = std::abs(lit) - selector_base;
+        if (offset < 0 || offset % selector_stride != 1) continue;
+        level.core.push_back(offset / selector_stride);
+    }
+}
+
+// 未最小化的 core：所有有效 (或所有無效) 的群組
+void QBFSolver::coreAll(int depth, bool active) {
+    Level& level = *levels[depth];
+    level.core.clear();
+    for (int i = 0; i < (int)level.assumptions.size(); i++) {
+        if (isActive(depth, i) == active) level.core.push_back(i);
+    }
+}
+
+// 核心 CEGAR 迴圈：不遞迴，而是在 levels 上以 depth 移動 (level stack)。
+// 往內走時由 enterLevel / nextCandidate 設定內層的 assumption；內層有結果時回到外層的 resumeLevel。
+// 每一層需要跨越內層求解的狀態 (模型、迭代次數、是否略過本層) 都放在 Level 中，
+// 因此原生堆疊的用量與 prefix 的深度無關。
+// 第 0 層的有效群組需已寫進 levels[0]->assumptions
+QBFResult QBFSolver::solveLevels(const std::vector<Formula>& prefix) {
+    QBFResult res = Q_UNKNOWN;
+    int depth = 0;
+    bool done = enterLevel(prefix, depth, res);
+    while (true) {
+        if (!done) {
+            depth++;
+            done = enterLevel(prefix, depth, res);
+            continue;
+        }
+        if (res == Q_UNKNOWN || depth == 0) return res;
+        storeResult(depth, res);
+        depth--;
+        done = resumeLevel(prefix, depth, res);
+    }
+}
+
+// 進入第 depth 層 (有效群組已由外層寫進 levels[depth]->assumptions)。
+// 本層已有結果時寫進 res 並回傳 true，結果所依賴的群組寫進 levels[depth]->core；
+// 需要先求解內層時回傳 false
+bool QBFSolver::enterLevel(const std::vector<Formula>& prefix, int depth, QBFResult& res) {
+    Level& level = *levels[depth];
+    LevelStats& ls = st.levels[depth];
+    ls.visits++;
+    st.max_recursion_depth = std::max(st.max_recursion_depth, depth);
+    level.cache_pending = false;
+
+    // 1. 基底情況 (Base Cases)
+    // 若沒有有效子句，代表所有子句皆已滿足 -> SAT
+    if (level.num_active == 0) {
+        coreAll(depth, false);
+        res = Q_SAT;
+        return true;
+    }
+    LOG_DEBUG("depth" << depth << " q=" << prefix[depth].quantifier << " active=" << level.num_active);
+
+    // 若有效子句中包含空子句 (代表出現了 False) -> UNSAT
+    if (level.num_dead > 0) {
+        LOG_DEBUG("Empty clause found: " << level.num_dead);
+        level.core.clear();
+        for (int i = 0; i < (int)level.assumptions.size(); i++) {
+            if (isActive(depth, i) && level.dead[i]) {
+                level.core.push_back(i);
+                if (options.minimize_refinement) break;
+            }
+        }
+        res = Q_UNSAT;
+        return true;
+    }
+
+    // 同一組有效群組之前已有結果：不必再求解本層與內層 (見 Level::cache)
+    if (depth > 0 && lookupResult(depth, res)) return true;
+
     const Formula& currentQ = prefix[depth];
-    // 2. 若已經處理完所有量詞，剩餘矩陣視為命題邏輯求解
+    const std::vector<int>& var_b = level.var_b;
+    std::vector<bool>& b = level.model;
+    int number_of_groups = var_b.size();
+
+    // 2. 最後一層：∃ 要滿足所有有效子句；∀ 只要能讓其中一個為假就贏了
     if (depth >= (int)prefix.size() - 1) {
-        std::cout << "last layer" << std::endl;
-        SATSolver sat;
-        for (const auto& c : matrix) sat.addClause(c);
-        if (currentQ.quantifier == 'a' && !sat.clauses.empty()) return Q_UNSAT;
-        std::map<int, bool> dummy_assignment;
-        // 收集剩餘矩陣中的所有變數
-        std::vector<int> remaining_vars;
-        for (const auto& c : matrix) {
-            for (int lit : c) {
-                int v = std::abs(lit);
-                remaining_vars.push_back(v);
-            }
+        LOG_DEBUG("last layer");
+        SATResult sat_res = solveAbstraction(depth);
+        if (sat_res == S_UNKNOWN) {
+            res = Q_UNKNOWN;
+            return true;
         }
-        // 移除重複變數
-        std::sort(remaining_vars.begin(), remaining_vars.end());
-        remaining_vars.erase(std::unique(remaining_vars.begin(), remaining_vars.end()), remaining_vars.end());
-
-        return (sat.solve(dummy_assignment, remaining_vars) == S_SAT) ? Q_SAT : Q_UNSAT;
-    }
-
-    // 3. 準備當前層級的抽象 (Abstraction)
-    std::cout << "current Q :" << currentQ.vars[0] <<std::endl;
-    SATSolver alpha;
-    
-    std::vector<int> vars_of_interest = currentQ.vars;
-    
-    int number_of_clauses = matrix.size();
-    std::vector<int> var_b;
-    for (int i = 0; i < number_of_clauses; i++){
-        var_b.push_back((next_ID + i));
-        vars_of_interest.push_back((next_ID + i));
-    }
-    if (currentQ.quantifier == 'e'){
-        int i = 0;
-        for (const auto& clause : matrix){
-            std::vector<int> clause_p;
-            for (int lit : clause){
-                int var = std::abs(lit);
-                for(int var_temp : currentQ.vars){
-                    if (var == var_temp){
-                        clause_p.push_back(lit);
-                        break;
-                    }
+        if (currentQ.quantifier == 'e') {
+            if (sat_res != S_SAT) {
+                coreFromConflict(depth, true);
+                res = Q_UNSAT;
+                return true;
+            }
+            // 只要沒被這組賦值滿足的子句都維持無效，結果就不變
+            level.core.clear();
+            for (int i = 0; i < number_of_groups; i++) {
+                if (!options.minimize_refinement ? !isActive(depth, i) : !satisfiedAt(i, depth, b)) {
+                    level.core.push_back(i);
                 }
             }
-            clause_p.push_back(var_b[i]);
-            alpha.addClause(clause_p);
-            i += 1;
-        }
-    }
-    if (currentQ.quantifier == 'a'){
-        int i = 0;
-        for (const auto& clause : matrix){
-            for (int lit : clause){
-                int var = std::abs(lit);
-                for(int var_temp : currentQ.vars){
-                    if (var == var_temp){
-                        std::vector<int> clause_p;
-                        clause_p.push_back(-lit);
-                        clause_p.push_back(-var_b[i]);
-                        alpha.addClause(clause_p);
-                        break;
-                    }
+            res = Q_SAT;
+            return true;
+        }
+        if (sat_res == S_SAT) {
+            // ∀ 讓 b 為 True 的子句為假；其中任何一個都足以使內層為 UNSAT
+            level.core.clear();
+            for (int i = 0; i < number_of_groups; i++) {
+                if (b[var_b[i]]) {
+                    level.core.push_back(i);
+                    if (options.minimize_refinement) break;
                 }
             }
-            i += 1;
+            res = Q_UNSAT;
+            return true;
         }
+        coreFromConflict(depth, false);
+        res = Q_SAT;
+        return true;
     }
-    
-    // 4. CEGAR 主迴圈
-    while (true) {
-        std::map<int, bool> b;
-        std::map<int, bool> assignment;
-        SATResult res = alpha.solve(assignment, vars_of_interest);
 
-        std::cout << "Current Assignment (b variables):" << std::endl;
-        for (const auto& [var, val] : assignment) {
-            // 使用 C++17 的結構化綁定 (Structured Bindings)
-            std::cout << "Variable " << var << " = " << (val ? "True" : "False") << std::endl;
+    // 3. 有效子句都不含本層的文字：本層怎麼選都一樣，
+    //    把有效子句原封不動交給內層，內層的結果與 core 直接沿用，不必呼叫 alpha
+    if (level.num_touching == 0) {
+        ls.skipped++;
+        level.skipping = true;
+        auto simplify_start = std::chrono::steady_clock::now();
+        const std::vector<int>& parent = levels[depth + 1]->parent;
+        for (int g = 0; g < (int)parent.size(); g++) {
+            setActive(depth + 1, g, isActive(depth, parent[g]));
         }
-        std::cout << "--------------------------" << std::endl;
+        ls.simplify_seconds += elapsedSeconds(simplify_start);
+        return false;
+    }
 
-        // 如果抽象層無解
-        if (res == S_UNSAT) {
-            // ∃ 量詞找不到解 -> UNSAT; ∀ 量詞找不到反例 -> SAT
-            return (currentQ.quantifier == 'e') ? Q_UNSAT : Q_SAT;
+    // 4. CEGAR 主迴圈：每一輪由 nextCandidate 開始，內層有結果後在 resumeLevel 細化
+    level.skipping = false;
+    level.iteration = 0;
+    return nextCandidate(prefix, depth, res);
+}
+
+// 第 depth 層的下一個候選賦值：找不到時本層有結果 (回傳 true)，
+// 否則把決策交給內層 (回傳 false)
+bool QBFSolver::nextCandidate(const std::vector<Formula>& prefix, int depth, QBFResult& res) {
+    Level& level = *levels[depth];
+    LevelStats& ls = st.levels[depth];
+    std::vector<bool>& b = level.model;
+
+    // 模型直接寫進本層的 b (以變數編號索引)，不再經過 std::map
+    ls.iterations++;
+    SATResult sat_res = solveAbstraction(depth);
+    if (sat_res == S_UNKNOWN) {
+        res = Q_UNKNOWN;
+        return true;
+    }
+
+    // 如果抽象層無解
+    if (sat_res == S_UNSAT) {
+        // ∃ 量詞找不到解 -> UNSAT; ∀ 量詞找不到反例 -> SAT
+        if (prefix[depth].quantifier == 'e') {
+            coreFromConflict(depth, true);
+            res = Q_UNSAT;
+            return true;
         }
+        coreFromConflict(depth, false);
+        res = Q_SAT;
+        return true;
+    }
 
-        // 5. 處理下一詞傳遞的資訊
-        std::vector<bool> next_top(number_of_clauses, false);
-        for (int i = 0; i < number_of_clauses; i++){
-            b.insert({(next_ID + i), assignment[i + next_ID]});
-            next_top[i] = (assignment[i + next_ID])? false : true; //
+    level.iteration++;
+#if LOG_TRACE_ENABLED
+    // 一行一個候選賦值：iter depth=D n=N assign <正負文字...>
+    {
+        std::string line;
+        for (int var : level.vars_of_interest) {
+            line += ' ';
+            line += std::to_string(b[var] ? var : -var);
         }
+        LOG_TRACE("iter depth=" << depth << " n=" << level.iteration << " assign" << line);
+    }
+#endif
+
+    // 5. 把本層的決策交給內層 (只更新有變化的 assumption，不複製矩陣)
+    auto simplify_start = std::chrono::steady_clock::now();
+    simplify(depth, b);
+    ls.simplify_seconds += elapsedSeconds(simplify_start);
+    return false;
+}
+
+// 內層 (depth + 1) 得到結果 res 後回到第 depth 層：細化後繼續找下一個候選賦值，
+// 或者本層也有了結果 (寫回 res 並回傳 true)
+bool QBFSolver::resumeLevel(const std::vector<Formula>& prefix, int depth, QBFResult& res) {
+    Level& level = *levels[depth];
+    const Formula& currentQ = prefix[depth];
+    const std::vector<int>& var_b = level.var_b;
+    std::vector<bool>& b = level.model;
 
-        // 5.1 簡化矩陣 (Substitution)
-        auto simplified_matrix = simplify(matrix, currentQ, next_top);
+    // 略過的一層：內層的結果與 core 直接沿用
+    if (level.skipping) {
+        liftCore(depth, levels[depth + 1]->core, level.core);
+        return true;
+    }
 
-        // 6. 遞迴求解內層
-        QBFResult recursiveRes = solve_recursive(prefix, depth + 1, simplified_matrix, next_ID);
+    // 6. 內層的 core 是內層的群組，先換成本層的群組
+    liftCore(depth, levels[depth + 1]->core, level.lifted);
+    const std::vector<int>& inner_core = level.lifted;
 
-        // 7. 細化 (Refinement)
-        if (currentQ.quantifier == 'e' && recursiveRes == Q_UNSAT) {
-            // ∃ 賦值失敗 -> 加入封鎖子句
-            std::cout << "e" << std::endl;
-            alpha.addClause(generateRefinementClauseE(b, var_b));
-        } 
-        else if (currentQ.quantifier == 'a' && recursiveRes == Q_SAT) {
-            // ∀ 嘗試的反例不成立 -> 加入封鎖子句
-            std::cout << "a" << std::endl;
-            alpha.addClause(generateRefinementClauseA(b, var_b));
-        } 
-        else {
-            // 成功找到 Existential SAT 或 Universal UNSAT (反例)
-            return (currentQ.quantifier == 'e') ? Q_SAT : Q_UNSAT;
+    // 7. 細化 (Refinement)
+    if (currentQ.quantifier == 'e' && res == Q_UNSAT) {
+        // ∃ 賦值失敗 -> inner_core 中至少一個群組必須在本層被滿足
+        LOG_DEBUG("refine depth=" << depth << " q=e size=" << (int)inner_core.size());
+        generateRefinementClauseE(inner_core, var_b, level.refinement);
+        addRefinement(depth, level.refinement);
+        return nextCandidate(prefix, depth, res);
+    }
+    if (currentQ.quantifier == 'a' && res == Q_SAT) {
+        // ∀ 嘗試的反例不成立 -> inner_core 中至少一個群組必須交給內層
+        LOG_DEBUG("refine depth=" << depth << " q=a size=" << (int)inner_core.size());
+        generateRefinementClauseA(inner_core, var_b, level.refinement);
+        // 加入新子句後，內層可能不再 SAT：∀ 的細化子句只在目前的 generation 有效
+        if (incremental) level.refinement.push_back(-generationLiteral());
+        addRefinement(depth, level.refinement);
+        return nextCandidate(prefix, depth, res);
+    }
+    if (currentQ.quantifier == 'e') {
+        // 成功找到 Existential SAT：內層要求無效的群組中，
+        // 本層已滿足的不會再被交下去，其餘的仍必須維持無效
+        if (!options.minimize_refinement) {
+            coreAll(depth, false);
+            return true;
         }
+        level.core.clear();
+        for (int i : inner_core) {
+            if (!satisfiedAt(i, depth, b)) level.core.push_back(i);
+        }
+        return true;
     }
+    // Universal UNSAT (反例)：內層的 core 都是本層交下去的群組，而它們必須有效
+    level.core = inner_core;
+    return true;
 }
 
-// TODO: finish the removal of finished clauses.
-// Remove the current variables 
-std::vector<std::vector<int>> QBFSolver::simplify(const std::vector<std::vector<int>>& matrix, const Formula& currentQ, std::vector<bool> next_top) {
-    std::vector<std::vector<int>> new_matrix;
-    int i = 0;
-    for (const auto& clause : matrix) {
-        if(next_top[i] == false){
-            std::vector<int> new_clause;
-
-            for (int lit : clause) {
-                int var = std::abs(lit);
-                
-                bool is_inQ = false;
-                for (int var_Q : currentQ.vars){
-                    if (var == var_Q) {
-                        is_inQ = true;
-                        break;
-                    }
-                }
-                if (!is_inQ){
-                    new_clause.push_back(lit);
-                }
-            }
-                new_matrix.push_back(new_clause);            
-        }
-        i += 1;
+// 在目前的 assumption 下求解本層的抽象，模型寫進 level.model，並記錄耗時
+SATResult QBFSolver::solveAbstraction(int depth) {
+    Level& level = *levels[depth];
+    if (!incremental) return timedSolve(level.alpha, level.model, level.assumptions, st.levels[depth]);
+
+    // 增量模式：∀ 層加上目前的 generation 文字，最外層加上呼叫端的 assumption
+    level.solve_assumptions = level.assumptions;
+    if (level.quantifier == 'a') level.solve_assumptions.push_back(generationLiteral());
+    if (depth == 0) level.solve_assumptions.insert(level.solve_assumptions.end(), outer_assumptions.begin(), outer_assumptions.end());
+    return timedSolve(level.alpha, level.model, level.solve_assumptions, st.levels[depth]);
+}
+
+// 已被中斷或超過時間上限時不再呼叫 SAT solver；每次 CEGAR 迭代都經過這裡，
+// 因此上限也在迭代之間檢查。進行中的呼叫在 deadline 由 timer 中斷 (startBudget)，
+// 不使用 setMaxTime：CMS 的時間上限是整個行程的 CPU 時間，平行求解時會提早用完。
+// conflict 上限交給 SAT solver；solver 會保留上一次設定的上限，所以沒有上限時也要明確設回不限制。
+// 耗時記在 ls
+SATResult QBFSolver::timedSolve(SATSolver& solver, std::vector<bool>& model, const std::vector<int>& assumptions, LevelStats& ls) {
+    if (interrupted()) return S_UNKNOWN;
+    auto sat_start = std::chrono::steady_clock::now();
+    if (sat_start >= interrupt_state->deadline) {
+        st.out_of_budget = true;
+        return S_UNKNOWN;
     }
-    return new_matrix;
+    solver.setMaxTime(std::numeric_limits<double>::infinity());
+    solver.setMaxConflicts(options.conflict_limit > 0 ? options.conflict_limit : -1);
+    SATResult res = solver.solve(model, assumptions);
+    if (res == S_UNKNOWN && !interrupted()) st.out_of_budget = true;
+    double seconds = elapsedSeconds(sat_start);
+    ls.sat_calls++;
+    ls.sat_seconds += seconds;
+    ls.max_sat_seconds = std::max(ls.max_sat_seconds, seconds);
+    return res;
 }
 
+// 把細化子句加進本層的 alpha
+void QBFSolver::addRefinement(int depth, const std::vector<int>& clause) {
+    Level& level = *levels[depth];
+    LevelStats& ls = st.levels[depth];
+    level.alpha.addClause(clause);
+    ls.refinements++;
+    ls.refinement_literals += clause.size();
+    ls.max_refinement_size = std::max(ls.max_refinement_size, (int)clause.size());
+    ls.peak_clauses = std::max(ls.peak_clauses, (int)level.alpha.numClauses());
+}
 
-// 生成封鎖子句 (Blocking Clause)
-std::vector<int> QBFSolver::generateRefinementClauseE(std::map<int, bool>& b, const std::vector<int>& vars) {
-    std::vector<int> clause;
-    for (int v : vars) {
-        if (b[v]) {
-            // The v-th clause has to solve the problem.
-            clause.push_back(-v);
-        }
+// 內層的有效群組 = 本層 b 為 True 的群組的子群組 (b -> act，已被滿足的群組不會被選到)。
+// 目前變數的移除由內層抽象的投影完成，因此這裡不需要複製矩陣。
+void QBFSolver::simplify(int depth, const std::vector<bool>& b) {
+    const Level& level = *levels[depth];
+    const std::vector<int>& parent = levels[depth + 1]->parent;
+    for (int g = 0; g < (int)parent.size(); g++) {
+        setActive(depth + 1, g, b[level.var_b[parent[g]]]);
+    }
+}
+
+
+// 生成封鎖子句 (Blocking Clause)，寫進 clause (呼叫端的暫存，覆寫原有內容)
+void QBFSolver::generateRefinementClauseE(const std::vector<int>& core, const std::vector<int>& vars, std::vector<int>& clause) {
+    clause.clear();
+    for (int i : core) {
+        // The i-th group has to be solved at this level.
+        clause.push_back(-vars[i]);
+    }
+}
+
+// 生成封鎖子句 (Blocking Clause)，寫進 clause (呼叫端的暫存，覆寫原有內容)
+void QBFSolver::generateRefinementClauseA(const std::vector<int>& core, const std::vector<int>& vars, std::vector<int>& clause) {
+    clause.clear();
+    for (int i : core) {
+        // The i-th group has to be falsified at this level.
+        clause.push_back(vars[i]);
+    }
+}
+
+// 依 options.time_limit 設定這次查詢的 deadline，有上限時啟動 timer
+void QBFSolver::startBudget() {
+    if (!owns_budget) return;
+    // 上一次查詢到期時設定的 cms 要清掉；interrupt 設定的 stop 則保留
+    interrupt_state->stopTimer();
+    interrupt_state->cms = false;
+    if (interrupted()) interrupt_state->cms = true;
+    if (options.time_limit <= 0) {
+        interrupt_state->deadline = std::chrono::steady_clock::time_point::max();
+        return;
     }
-    return clause;
+    auto limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.time_limit));
+    interrupt_state->deadline = std::chrono::steady_clock::now() + limit;
+    interrupt_state->startTimer();
 }
 
-// 生成封鎖子句 (Blocking Clause)
-std::vector<int> QBFSolver::generateRefinementClauseA(std::map<int, bool>& b, const std::vector<int>& vars) {
-    std::vector<int> clause;
-    for (int v : vars) {
-        if (!b[v]) {
-            // The v-th clause has to avoid the problem.
-            clause.push_back(v);
+// 查詢結束：停止 timer (不等到 deadline)
+void QBFSolver::stopBudget() {
+    if (owns_budget) interrupt_state->stopTimer();
+}
+
+// 到 deadline 時設定 cms，讓進行中的 SAT 呼叫停下。CMS 可能在 solve 開始時清除 cms，
+// 所以到期後每 10 ms 重新設定一次，直到 stopTimer
+void QBFSolver::InterruptState::startTimer() {
+    stopTimer();
+    timer_done = false;
+    auto until = deadline;
+    timer = std::thread([this, until]() {
+        std::unique_lock<std::mutex> lock(timer_mutex);
+        if (timer_cv.wait_until(lock, until, [this]() { return timer_done; })) return;
+        while (true) {
+            cms = true;
+            if (timer_cv.wait_for(lock, std::chrono::milliseconds(10), [this]() { return timer_done; })) return;
         }
+    });
+}
+
+void QBFSolver::InterruptState::stopTimer() {
+    if (!timer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(timer_mutex);
+        timer_done = true;
+    }
+    timer_cv.notify_all();
+    timer.join();
+}
+
+SATConfig QBFSolver::satConfig() const {
+    SATConfig config;
+    config.seed = options.seed;
+    config.polarity = options.polarity;
+    config.restart = options.restart;
+    return config;
+}
+
+void QBFSolver::interrupt() {
+    interrupt_state->stop = true;
+    interrupt_state->cms = true;
+}
+
+double QBFSolver::elapsedSeconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// 子問題的統計累加進來：計數相加，最大值取最大
+void QBFSolver::Stats::merge(const Stats& other) {
+    max_recursion_depth = std::max(max_recursion_depth, other.max_recursion_depth);
+    out_of_budget = out_of_budget || other.out_of_budget;
+    if (levels.size() < other.levels.size()) levels.resize(other.levels.size());
+    for (size_t depth = 0; depth < other.levels.size(); depth++) {
+        LevelStats& ls = levels[depth];
+        const LevelStats& o = other.levels[depth];
+        ls.quantifier = o.quantifier;
+        ls.vars += o.vars;
+        ls.visits += o.visits;
+        ls.skipped += o.skipped;
+        ls.iterations += o.iterations;
+        ls.sat_calls += o.sat_calls;
+        ls.sat_seconds += o.sat_seconds;
+        ls.max_sat_seconds = std::max(ls.max_sat_seconds, o.max_sat_seconds);
+        ls.refinements += o.refinements;
+        ls.refinement_literals += o.refinement_literals;
+        ls.max_refinement_size = std::max(ls.max_refinement_size, o.max_refinement_size);
+        ls.simplify_seconds += o.simplify_seconds;
+        ls.peak_clauses = std::max(ls.peak_clauses, o.peak_clauses);
+        ls.groups += o.groups;
+        ls.cache_hits += o.cache_hits;
+        ls.cache_misses += o.cache_misses;
+        ls.cache_bytes = std::max(ls.cache_bytes, o.cache_bytes);
+    }
+}
+
+// 一個物件一行，方便用 grep / jq 處理
+void QBFSolver::writeStatsJson(std::ostream& os) const {
+    double seconds = (st.seconds > 0) ? st.seconds : elapsedSeconds(start_time);
+    os << "{\n"
+       << "  \"seconds\": " << seconds << ",\n"
+       << "  \"preprocess_seconds\": " << st.preprocess_seconds << ",\n"
+       << "  \"clauses_before\": " << st.clauses_before << ",\n"
+       << "  \"clauses_after\": " << st.clauses_after << ",\n"
+       << "  \"prefix_blocks\": " << st.prefix_blocks << ",\n"
+       << "  \"components\": " << st.components << ",\n"
+       << "  \"max_recursion_depth\": " << st.max_recursion_depth << ",\n"
+       << "  \"out_of_budget\": " << (st.out_of_budget ? "true" : "false") << ",\n"
+       << "  \"levels\": [";
+    for (size_t depth = 0; depth < st.levels.size(); depth++) {
+        const LevelStats& ls = st.levels[depth];
+        os << (depth == 0 ? "\n" : ",\n")
+           << "    {\"depth\": " << depth
+           << ", \"quantifier\": \"" << ls.quantifier << "\""
+           << ", \"vars\": " << ls.vars
+           << ", \"visits\": " << ls.visits
+           << ", \"skipped\": " << ls.skipped
+           << ", \"iterations\": " << ls.iterations
+           << ", \"sat_calls\": " << ls.sat_calls
+           << ", \"sat_seconds\": " << ls.sat_seconds
+           << ", \"max_sat_seconds\": " << ls.max_sat_seconds
+           << ", \"refinements\": " << ls.refinements
+           << ", \"refinement_literals\": " << ls.refinement_literals
+           << ", \"max_refinement_size\": " << ls.max_refinement_size
+           << ", \"simplify_seconds\": " << ls.simplify_seconds
+           << ", \"peak_clauses\": " << ls.peak_clauses
+           << ", \"groups\": " << ls.groups
+           << ", \"cache_hits\": " << ls.cache_hits
+           << ", \"cache_misses\": " << ls.cache_misses
+           << ", \"cache_hit_rate\": " << (ls.cache_hits + ls.cache_misses > 0 ? (double)ls.cache_hits / (ls.cache_hits + ls.cache_misses) : 0)
+           << ", \"cache_bytes\": " << ls.cache_bytes << "}";
     }
-    return clause;
+    os << (st.levels.empty() ? "]\n" : "\n  ]\n") << "}" << std::endl;
 }
@@ -1,10 +1,23 @@
 #ifndef QBFSOLVER_H
 #define QBFSOLVER_H
 
+#include "clause_db.h"
 #include "sat.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
-enum QBFResult { Q_SAT, Q_UNSAT };
+struct Component;
+
+// Q_UNKNOWN：求解在得到答案前被中斷 (QBFSolver::interrupt) 或用完了時間 / conflict 上限
+enum QBFResult { Q_SAT, Q_UNSAT, Q_UNKNOWN };
 
 class QBFSolver {
 public:
@@ -13,13 +26,269 @@ public:
         std::vector<int> vars;
     };
 
-    QBFResult solve(std::vector<Formula>& prefix, std::vector<std::vector<int>> matrix);
+    // 求解設定，需在 solve 之前設定
+    struct Options {
+        bool use_xor = true;    // 找出以 CNF 編碼的 XOR，並以 add_xor_clause 交給各層的 SAT solver
+        bool gauss = true;      // 在收到 XOR 的 SAT solver 上開啟 Gauss-Jordan elimination
+        int max_xor_size = 6;   // 只找長度不超過此值的 XOR
+        bool minimize_refinement = true; // 細化子句只提到內層結果真正依賴的子句 (UNSAT core)
+
+        // CEGAR 之前的前處理 (見 preprocess.h)，各項技術可分別關閉
+        bool preprocess = true;
+        bool universal_reduction = true;
+        bool unit_propagation = true;
+        bool pure_literals = true;
+        bool blocked_clauses = true;
+
+        // 前處理之後：以 dependency schemes 化簡並重新排列 prefix (見 dependency.h)
+        bool dependencies = true;
+
+        // 正規化 prefix，並把互不相交的子句群拆成獨立的子 QBF (見 miniscope.h)
+        bool miniscope = true;
+        int component_threads = 1; // 同時求解的子 QBF 數，1 為依序求解
+
+        int polarity = -1;      // 各層 SAT solver 的 default polarity：-1 不設定，0 為 false，1 為 true
+        unsigned seed = 0;      // 各層 CMS 的 random seed
+        SATRestart restart = R_DEFAULT; // 各層 CMS 的 restart 策略
+        int small_sat_vars = 100; // 用到的變數不超過此數的 SAT solver 使用內建的小型 CDCL (見 sat.h)，0 為一律使用 CMS
+        int result_cache = 1024; // 每一層最多記住的內層結果數 (見 Level::cache)，0 為不使用
+        bool two_qbf = true;    // 正規化後只剩兩個區塊時使用專門的 2QBF 引擎
+
+        // 每次查詢 (solve / solveAssuming) 的上限，超過時回傳 Q_UNKNOWN；0 為不限制
+        double time_limit = 0;      // wall-clock 秒數，到期時由計時 thread 中斷進行中的 SAT 呼叫
+        long long conflict_limit = 0; // 單次 SAT 呼叫的 conflict 數
+    };
+    Options options;
+
+    // 先做前處理 (options.preprocess) 與 miniscoping (options.miniscope)，再以 CEGAR 求解
+    QBFResult solve(std::vector<Formula>& prefix, const ClauseDB& matrix);
+
+    // 增量介面：同一個公式上的多次查詢共用各層的抽象與細化子句。
+    // load 之後可以交錯呼叫 addClause 與 solveAssuming；不做前處理、miniscoping 與 2QBF
+    // (它們會改寫公式，之後加入的子句無法對應)。
+    void load(const std::vector<Formula>& prefix, const ClauseDB& matrix);
+
+    // 加入一個子句 (只能使用 load 時 prefix 中的變數，否則回傳 false 且不做任何變動)
+    bool addClause(const std::vector<int>& clause);
+
+    // 在最外層區塊的文字固定為 assumptions 之下求解；assumptions 不會留下。
+    // 含有其他區塊的變數時回傳 Q_UNKNOWN
+    QBFResult solveAssuming(const std::vector<int>& assumptions);
+
+    // 變數所在的量詞區塊：level 為 prefix 中的索引 (未被量化為 -1)，quantifier 為 'e' 或 'a'
+    struct VarInfo {
+        int level;
+        char quantifier;
+    };
+    // O(1) 查詢，表格在 solve 開始時由 prefix 建立一次
+    int levelOf(int var) const { return var_info[var].level; }
+    char quantifierOf(int var) const { return var_info[var].quantifier; }
+
+    // 每一層的統計 (以正規化後 prefix 的層數索引；miniscoping 的子問題依層數累加)
+    struct LevelStats {
+        char quantifier = 'e';
+        int vars = 0;
+        long long visits = 0;               // 進入本層的次數
+        long long skipped = 0;              // 本層沒有有效文字、直接交給內層的次數
+        long long iterations = 0;           // CEGAR 迭代次數
+        long long sat_calls = 0;            // alpha.solve 次數
+        double sat_seconds = 0;
+        double max_sat_seconds = 0;         // 單次 alpha.solve 的最長時間
+        long long refinements = 0;
+        long long refinement_literals = 0;  // 所有細化子句的長度總和
+        int max_refinement_size = 0;
+        double simplify_seconds = 0;        // 把決策交給內層 (更新 assumption) 的時間
+        int peak_clauses = 0;               // alpha 中的子句數 (只增不減)
+        int groups = 0;                     // 子句群組數 (共用選擇變數的子句算一組)
+        long long cache_hits = 0;           // 進入本層時直接沿用快取結果的次數
+        long long cache_misses = 0;         // 查詢快取但沒有命中的次數
+        long long cache_bytes = 0;          // 快取佔用的記憶體 (估計值) 的最大值
+    };
+
+    struct Stats {
+        double seconds = 0;                 // solve 總時間，求解中為 0
+        double preprocess_seconds = 0;
+        int clauses_before = 0;             // 輸入的子句數
+        int clauses_after = 0;              // 前處理後的子句數
+        int prefix_blocks = 0;              // 正規化後的區塊數
+        int components = 1;
+        int max_recursion_depth = 0;        // 實際走到的最深層數 (level stack 的深度)
+        bool out_of_budget = false;         // 因 time_limit / conflict_limit 而回傳 Q_UNKNOWN
+        std::vector<LevelStats> levels;
+
+        void merge(const Stats& other);
+    };
+
+    const Stats& stats() const { return st; }
+
+    // 以 JSON 輸出統計；可在求解中途呼叫 (例如 SIGINT)，此時時間以目前為止計算
+    void writeStatsJson(std::ostream& os) const;
+
+    // 可由其他 thread 呼叫：正在進行的 SAT 呼叫交給 CMS 中斷，
+    // 之後每一層在下一次 SAT 呼叫前停下，solve 回傳 Q_UNKNOWN
+    void interrupt();
 
 private:
-    QBFResult solve_recursive(const std::vector<Formula>& prefix, int depth, std::vector<std::vector<int>> matrix, int next_var);
-    std::vector<std::vector<int>> simplify(const std::vector<std::vector<int>>& matrix, const Formula& currentQ, std::vector<bool> next_top);
-    std::vector<int> generateRefinementClauseE(std::map<int, bool>& b, const std::vector<int>& vars);
-    std::vector<int> generateRefinementClauseA(std::map<int, bool>& b, const std::vector<int>& vars);
+    // 中斷旗標與時間上限，miniscoping 的子問題與父問題共用同一份。
+    // stop 只會被設為 true；cms 交給各層的 SAT solver，CMS 可能在每次 solve 開始時清除它。
+    // deadline 在每次查詢開始時依 options.time_limit 設定。CMS 的 set_max_time 算的是整個行程的 CPU 時間
+    // (其他 thread 也算在內)，所以時間上限由 timer 以 wall-clock 執行：到期時設定 cms
+    struct InterruptState {
+        std::atomic<bool> stop{false};
+        std::atomic<bool> cms{false};
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        std::thread timer;
+        std::mutex timer_mutex;
+        std::condition_variable timer_cv;
+        bool timer_done = false;
+        ~InterruptState() { stopTimer(); }
+        void startTimer();
+        void stopTimer();
+    };
+    std::shared_ptr<InterruptState> interrupt_state = std::make_shared<InterruptState>();
+    bool owns_budget = true; // miniscoping 的子問題為 false：沿用父問題的 deadline 與 timer
+    bool interrupted() const { return interrupt_state->stop.load(std::memory_order_relaxed); }
+    void startBudget();
+    void stopBudget();
+    SATConfig satConfig() const; // options 中交給每個 SAT solver 的設定
+
+    Stats st;
+    std::chrono::steady_clock::time_point start_time;
+
+    std::vector<VarInfo> var_info; // 以變數編號索引
+
+    // 選擇變數的編號：每一層的群組 g 的 var_b 為 selector_base + selector_stride * g，var_act 為其後一個。
+    // 增量模式下 stride 為 3，每個群組的第三個編號留給 generation 文字 (見 generationLiteral)。
+    int selector_base = 0;
+    int selector_stride = 2;
+
+    // 增量模式 (load)：∀ 層的細化子句與最後一層的覆蓋子句都帶有 -g，g 為目前 generation 的文字，
+    // 只在 assumption g 之下有效。加入新子句後內層可能不再 SAT，這些子句隨即失效：
+    // 下一次求解前加入單位子句 -g 並改用新的 g。∃ 層的細化子句只會因為子句變多而更強，一直保留。
+    bool incremental = false;
+    int generation = 0;
+    bool generation_stale = false;
+    std::vector<int> outer_assumptions; // 最外層的 assumption (solveAssuming)
+    int generationLiteral() const { return selector_base + selector_stride * generation + 2; }
+
+    // 子句投影的雜湊 (FNV-1a)
+    struct KeyHash {
+        size_t operator()(const std::vector<int>& key) const {
+            uint64_t hash = 1469598103934665603ull;
+            for (int x : key) hash = (hash ^ (uint32_t)x) * 1099511628211ull;
+            return hash;
+        }
+    };
+
+    // 每一層量詞各自擁有一個長期存在的抽象 (abstraction)，只在 solve 中建立一次。
+    // 在本層與所有外層的投影都相同 (且同樣有或沒有更內層文字) 的子句，到本層為止的行為完全一樣，
+    // 因此合成一個群組 (group)，共用一組變數：
+    //   var_b[g]   : 本層沒有滿足群組 g，要交給內層處理 (不含本層文字的群組直接以 var_act 代替)
+    //   var_act[g] : 群組 g 尚未被外層滿足，由外層的決策以 assumption 給定
+    // 內層的群組再依內層的投影細分：parent 記錄它屬於本層的哪一個群組。
+    // 細化子句只提到 var_b，與外層的決策無關，因此可以一直留在 alpha 中。
+    struct Level {
+        Level(std::atomic<bool>* interrupt, int small_vars, const SATConfig& config) : alpha(interrupt, small_vars, config) {}
+
+        SATSolver alpha;
+        char quantifier = 'e';
+        bool is_last = false;
+        std::vector<int> vars_of_interest;
+        std::vector<bool> model; // 本層最近一次的模型，以變數編號索引，跨迭代重複使用
+        bool has_xor = false;    // alpha 中是否有原生 XOR 限制
+        std::vector<int> var_b;
+        std::vector<int> var_act;
+
+        std::vector<int> parent;  // parent[g]：外層 (depth - 1) 中包含群組 g 的群組，最外層為 -1
+        std::vector<int> rep;     // rep[g]：群組 g 的代表子句，用來讀取本層的投影
+        std::vector<char> dead;   // dead[g]：群組 g 在本層以內已沒有文字 (有效時為空子句)
+        // (parent, 是否有更內層的文字, 排序後的本層投影) -> 群組；只在建立抽象與增量模式中使用
+        std::unordered_map<std::vector<int>, int, KeyHash> group_index;
+        std::vector<int> key;     // group_index 查詢的暫存
+
+        // 外層目前的決策：assumptions[g] 為 var_act[g] 或 -var_act[g]。
+        // 由外層的 simplify 就地更新，只改動有變化的選擇變數。
+        std::vector<int> assumptions;
+        int num_active = 0; // 仍有效的群組數
+        int num_dead = 0;   // 仍有效、但在本層以內已沒有文字的群組數 (空子句)
+        std::vector<char> touches; // touches[g]：群組 g 含有本層區塊的文字
+        int num_touching = 0;      // 仍有效、且含有本層文字的群組數；為 0 時本層的決策無關緊要
+
+        // 本層上一次結果所依賴的群組 (本層的群組編號)：
+        //   Q_UNSAT : 這些群組只要都有效，本層必定 UNSAT (必須有效的群組)
+        //   Q_SAT   : 只要這些群組都無效，本層必定 SAT (必須無效的群組)
+        // 外層把它換成外層的群組 (liftCore) 後產生細化子句；未最小化時即為全部有效 / 全部無效的群組。
+        std::vector<int> core;
+        std::vector<int> lifted; // 內層 core 換成本層群組的暫存
+        std::vector<int> failed; // failedAssumptions 的暫存
+        std::vector<int> solve_assumptions; // 增量模式下實際交給 alpha 的 assumption
+        std::vector<int> refinement; // 細化子句的暫存
+        // 以上暫存都跨迭代重複使用：容量穩定後，CEGAR 迭代本身不再配置記憶體
+
+        // solveLevels 在內層求解期間保留的狀態
+        bool skipping = false; // 本層沒有有效文字，直接把內層的結果往外傳
+        int iteration = 0;     // 本次進入後的候選賦值數
+
+        // 結果快取 (只用在 depth >= 1)：本層的結果只由有效群組決定，
+        // 而各層的細化子句都是公式本身的推論，因此同一組有效群組再次出現時 (通常來自外層的另一個分支)
+        // 可以直接沿用上次的結果與 core。公式改變 (addClause) 時清空。
+        struct CachedResult {
+            QBFResult res;
+            std::vector<int> core;
+        };
+        std::vector<int> active_bits; // assumptions 的位元版本 (群組 g 為第 g 個位元)，由 setActive 維護，即快取的 key
+        std::unordered_map<std::vector<int>, CachedResult, KeyHash> cache;
+        long long cache_bytes = 0;
+        bool cache_pending = false; // 本次進入沒有命中：有結果時記進快取
+    };
+    std::vector<std::unique_ptr<Level>> levels;
+
+    // clause_depth[i]：子句 i 中最內層文字所在的層數，空子句為 -1
+    std::vector<int> clause_depth;
+    const ClauseDB* matrix = nullptr;
+
+    // 前處理與正規化後的公式
+    std::vector<Formula> work_prefix;
+    ClauseDB work_matrix;
+    ClauseDB reduced_matrix; // dependency-aware universal reduction 的結果
+
+    QBFResult solvePipeline(std::vector<Formula>& prefix, const ClauseDB& matrix);
+    QBFResult solveComponents(std::vector<Component>& components);
+    QBFResult solveFormula(std::vector<Formula>& prefix, const ClauseDB& matrix);
+    static int maxVarOf(const std::vector<Formula>& prefix, const ClauseDB& matrix);
+    void initLevelStats(const std::vector<Formula>& prefix);
+    void buildAbstraction(const std::vector<Formula>& prefix, const ClauseDB& matrix, int max_ID);
+    void buildVarTable(const std::vector<Formula>& prefix, int max_ID);
+    QBFResult solve2QBF(const std::vector<Formula>& prefix, const ClauseDB& matrix, int max_ID);
+    QBFResult solve2QBFExistsForall(const ClauseDB& matrix, int max_ID);
+    QBFResult solve2QBFForallExists(const ClauseDB& matrix, int max_ID);
+    void add2QBFXors(SATSolver& solver, const ClauseDB& matrix, int depth);
+    void addXors(const ClauseDB& matrix);
+    void buildLevel(const std::vector<Formula>& prefix, int depth, std::vector<int>& group_of);
+    int groupOf(int depth, int parent, int clause);
+    void addGroupToLevel(int depth, int parent, int clause);
+    void addLeafCover(int depth);
+    void nextGeneration();
+    void setActive(int depth, int group, bool active);
+    bool lookupResult(int depth, QBFResult& res);
+    void storeResult(int depth, QBFResult res);
+    void clearResultCaches();
+    bool isActive(int depth, int group) const { return levels[depth]->assumptions[group] > 0; }
+    bool satisfiedAt(int group, int depth, const std::vector<bool>& model) const;
+    void liftCore(int depth, const std::vector<int>& inner_core, std::vector<int>& core) const;
+    void coreFromConflict(int depth, bool active);
+    void coreAll(int depth, bool active);
+    QBFResult solveLevels(const std::vector<Formula>& prefix);
+    bool enterLevel(const std::vector<Formula>& prefix, int depth, QBFResult& res);
+    bool nextCandidate(const std::vector<Formula>& prefix, int depth, QBFResult& res);
+    bool resumeLevel(const std::vector<Formula>& prefix, int depth, QBFResult& res);
+    void simplify(int depth, const std::vector<bool>& b);
+    SATResult solveAbstraction(int depth);
+    SATResult timedSolve(SATSolver& solver, std::vector<bool>& model, const std::vector<int>& assumptions, LevelStats& ls);
+    void addRefinement(int depth, const std::vector<int>& clause);
+    static double elapsedSeconds(std::chrono::steady_clock::time_point since);
+    void generateRefinementClauseE(const std::vector<int>& core, const std::vector<int>& vars, std::vector<int>& clause);
+    void generateRefinementClauseA(const std::vector<int>& core, const std::vector<int>& vars, std::vector<int>& clause);
 };
 
-#endif
\ No newline at end of file
+#endif
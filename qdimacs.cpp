@@ -0,0 +1,239 @@
+#include "qdimacs.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 掃描游標：只在 [p, end) 之間移動
+struct Cursor {
+    const char* p;
+    const char* end;
+    int line;
+};
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline void skipBlanks(Cursor& cur) {
+    while (cur.p < cur.end && isBlank(*cur.p)) cur.p++;
+}
+
+inline void skipLine(Cursor& cur) {
+    while (cur.p < cur.end && *cur.p != '\n') cur.p++;
+}
+
+// 讀一個（可能帶負號的）十進位整數
+bool readInt(Cursor& cur, long long& value) {
+    bool negative = false;
+    if (cur.p < cur.end && (*cur.p == '-' || *cur.p == '+')) {
+        negative = (*cur.p == '-');
+        cur.p++;
+    }
+    if (cur.p >= cur.end || *cur.p < '0' || *cur.p > '9') return false;
+    long long v = 0;
+    while (cur.p < cur.end && *cur.p >= '0' && *cur.p <= '9') {
+        v = v * 10 + (*cur.p - '0');
+        if (v > 0x7fffffff) return false;
+        cur.p++;
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+std::string where(const Cursor& cur) {
+    return "line " + std::to_string(cur.line) + ": ";
+}
+
+} // namespace
+
+bool parseQDIMACS(const char* begin, const char* end, std::vector<QBFSolver::Formula>& prefix, ClauseDB& matrix, std::string& error) {
+    prefix.clear();
+    matrix.clear();
+
+    Cursor cur{begin, end, 1};
+    long long num_vars = -1, num_clauses = -1;
+    int max_seen = 0;              // prefix 與子句中出現過的最大變數
+    std::vector<char> bound;       // 該變數是否已出現在 prefix 中 (只配置到出現過的最大變數)
+    bool in_clause = false;        // 上一個子句尚未以 0 結尾
+    bool seen_clause = false;
+
+    while (true) {
+        skipBlanks(cur);
+        if (cur.p >= cur.end) break;
+        char c = *cur.p;
+
+        if (c == '\n') {
+            cur.p++;
+            cur.line++;
+            continue;
+        }
+
+        // 1. 註解
+        if (c == 'c' && !in_clause) {
+            skipLine(cur);
+            continue;
+        }
+
+        // 2. 檔頭 p cnf <vars> <clauses>
+        if (c == 'p' && !in_clause) {
+            if (num_vars >= 0) {
+                error = where(cur) + "duplicate problem line";
+                return false;
+            }
+            cur.p++;
+            skipBlanks(cur);
+            if (cur.end - cur.p < 3 || cur.p[0] != 'c' || cur.p[1] != 'n' || cur.p[2] != 'f') {
+                error = where(cur) + "expected 'p cnf'";
+                return false;
+            }
+            cur.p += 3;
+            skipBlanks(cur);
+            if (!readInt(cur, num_vars) || num_vars < 0) {
+                error = where(cur) + "bad variable count";
+                return false;
+            }
+            skipBlanks(cur);
+            if (!readInt(cur, num_clauses) || num_clauses < 0) {
+                error = where(cur) + "bad clause count";
+                return false;
+            }
+            // 檔頭的數量不一定與內容相符：每個子句至少佔 2 個位元組 ("0\n")，
+            // 預留的子句數以剩下的輸入為上限；文字數量以檔案大小粗估。
+            // 變數數量只用來檢查文字，陣列依實際出現的最大變數配置
+            size_t remaining = cur.end - cur.p;
+            matrix.reserve(std::min<size_t>(num_clauses, remaining / 2), remaining / 4);
+            skipLine(cur);
+            continue;
+        }
+
+        if (num_vars < 0) {
+            error = where(cur) + "missing 'p cnf' header";
+            return false;
+        }
+
+        // 3. 量詞區塊 e/a <vars> 0
+        if ((c == 'e' || c == 'a') && !in_clause) {
+            if (seen_clause) {
+                error = where(cur) + "quantifier block after the first clause";
+                return false;
+            }
+            cur.p++;
+            prefix.push_back({c, {}});
+            std::vector<int>& vars = prefix.back().vars;
+            while (true) {
+                skipBlanks(cur);
+                long long v;
+                if (!readInt(cur, v) || v < 0) {
+                    error = where(cur) + "bad variable in quantifier block";
+                    return false;
+                }
+                if (v == 0) break;
+                if (v > num_vars) {
+                    error = where(cur) + "variable " + std::to_string(v) + " exceeds header";
+                    return false;
+                }
+                if (v >= (long long)bound.size()) {
+                    try {
+                        bound.resize(std::max<size_t>(v + 1, 2 * bound.size()), 0);
+                    } catch (const std::bad_alloc&) {
+                        error = where(cur) + "variable " + std::to_string(v) + " too large";
+                        return false;
+                    }
+                }
+                if (bound[v]) {
+                    error = where(cur) + "variable " + std::to_string(v) + " quantified twice";
+                    return false;
+                }
+                max_seen = std::max(max_seen, (int)v);
+                bound[v] = 1;
+                vars.push_back((int)v);
+            }
+            continue;
+        }
+
+        // 4. 子句文字，直接寫進 matrix 的文字池
+        long long lit;
+        if (!readInt(cur, lit)) {
+            error = where(cur) + "unexpected character '" + std::string(1, c) + "'";
+            return false;
+        }
+        seen_clause = true;
+        if (lit == 0) {
+            matrix.endClause();
+            in_clause = false;
+            continue;
+        }
+        if (std::llabs(lit) > num_vars) {
+            error = where(cur) + "literal " + std::to_string(lit) + " exceeds header";
+            return false;
+        }
+        matrix.addLiteral((int)lit);
+        max_seen = std::max(max_seen, (int)std::llabs(lit));
+        in_clause = true;
+    }
+    // 最後一個子句缺少結尾的 0 時仍然接受
+    if (in_clause) matrix.endClause();
+
+    if (num_vars < 0) {
+        error = "missing 'p cnf' header";
+        return false;
+    }
+
+    // 自由變數依 QDIMACS 語意視為最外層的存在量詞。
+    // 大於 max_seen 的變數在公式中沒有出現，不影響結果，不必加入
+    std::vector<int> free_vars;
+    try {
+        for (int v = 1; v <= max_seen; v++) {
+            if (v >= (int)bound.size() || !bound[v]) free_vars.push_back(v);
+        }
+    } catch (const std::bad_alloc&) {
+        error = "variable " + std::to_string(max_seen) + " too large";
+        return false;
+    }
+    if (!free_vars.empty()) {
+        if (!prefix.empty() && prefix.front().quantifier == 'e') {
+            prefix.front().vars.insert(prefix.front().vars.begin(), free_vars.begin(), free_vars.end());
+        } else {
+            prefix.insert(prefix.begin(), {'e', std::move(free_vars)});
+        }
+    }
+    return true;
+}
+
+bool parseQDIMACS(const char* path, std::vector<QBFSolver::Formula>& prefix, ClauseDB& matrix, std::string& error) {
+    bool from_stdin = (path[0] == '-' && path[1] == '\0');
+    int fd = from_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    // 一般檔案走 mmap；pipe 等無法映射的輸入才整段讀進緩衝區
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            const char* begin = static_cast<const char*>(data);
+            bool ok = parseQDIMACS(begin, begin + st.st_size, prefix, matrix, error);
+            munmap(data, st.st_size);
+            if (!from_stdin) close(fd);
+            return ok;
+        }
+    }
+
+    std::string buffer;
+    char chunk[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) buffer.append(chunk, n);
+    if (!from_stdin) close(fd);
+    if (n < 0) {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+    return parseQDIMACS(buffer.data(), buffer.data() + buffer.size(), prefix, matrix, error);
+}
@@ -0,0 +1,17 @@
+#ifndef QDIMACS_H
+#define QDIMACS_H
+
+#include "clause_db.h"
+#include "qbf.h"
+#include <string>
+#include <vector>
+
+// 讀取 QDIMACS 檔案，直接填入 solver 的 prefix 與 matrix。
+// 檔案以 mmap 映射後逐字元掃描，不經過 iostream。
+// path 為 "-" 時改讀 stdin。失敗時回傳 false 並把原因寫入 error。
+bool parseQDIMACS(const char* path, std::vector<QBFSolver::Formula>& prefix, ClauseDB& matrix, std::string& error);
+
+// 同上，但解析一段已在記憶體中的內容 [begin, end)
+bool parseQDIMACS(const char* begin, const char* end, std::vector<QBFSolver::Formula>& prefix, ClauseDB& matrix, std::string& error);
+
+#endif
@@ -1,54 +1,207 @@
 #include "sat.h"
+#include "small_sat.h"
+#include <solverconf.h>
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
-SATSolver::SATSolver() {
-    // 可以在這裡設定 CMS 參數，例如執行緒數量
-    solver.set_num_threads(1); 
+SATSolver::SATSolver(std::atomic<bool>* interrupt, int small_vars, const SATConfig& config) : interrupt(interrupt), small_vars(small_vars), config(config) {
+    if (small_vars > 0) {
+        small = std::make_unique<SmallSAT>(interrupt);
+        if (config.polarity >= 0) small->setPolarity(config.polarity == 1);
+    } else {
+        startCMS();
+    }
 }
 
 SATSolver::~SATSolver() {}
 
-void SATSolver::ensure_vars(int max_var_id) {
-    // CMS 需要手動增加變數數量
-    while (max_var_id >= (int)solver.nVars()) {
-        solver.new_var();
+void SATSolver::startCMS() {
+    // seed、polarity 與 restart 以 SolverConf 在建立時交給 CMS (建構子會複製一份)
+    CMSat::SolverConf conf;
+    conf.origSeed = config.seed;
+    if (config.polarity >= 0) conf.polarity_mode = (config.polarity == 1) ? CMSat::PolarityMode::polarmode_pos : CMSat::PolarityMode::polarmode_neg;
+    if (config.restart == R_GLUE) conf.restartType = CMSat::Restart::glue;
+    if (config.restart == R_GEOMETRIC) conf.restartType = CMSat::Restart::geom;
+    if (config.restart == R_LUBY) conf.restartType = CMSat::Restart::luby;
+    solver = std::make_unique<CMSat::SATSolver>(&conf, interrupt);
+    // 可以在這裡設定 CMS 參數，例如執行緒數量
+    solver->set_num_threads(1);
+    if (time_limit != std::chrono::steady_clock::time_point::max()) {
+        std::chrono::duration<double> left = time_limit - std::chrono::steady_clock::now();
+        solver->set_max_time(std::max(0.0, left.count()));
+    }
+    if (conflict_limit >= 0) solver->set_max_confl((uint64_t)conflict_limit);
+}
+
+// SmallSAT 的原始子句 (含第 0 層的單位文字) 交給 CMS，學習子句不搬
+void SATSolver::switchToCMS() {
+    startCMS();
+    max_var = std::max(max_var, small->maxVar());
+    std::vector<int> lits, clause;
+    small->originalClauses(lits);
+    for (int lit : lits) {
+        if (lit != 0) {
+            clause.push_back(lit);
+            continue;
+        }
+        addCMSClause(clause);
+        clause.clear();
     }
+    small.reset();
+}
+
+// 外部變數 -> CMS 變數 (0-indexed)；第一次出現時配置下一個編號，
+// 實際建立 CMS 變數則留給 syncVars 一次完成
+unsigned SATSolver::cmsVar(int var) {
+    max_var = std::max(max_var, var);
+    if (var >= (int)ext2cms.size()) ext2cms.resize(var + 1, -1);
+    if (ext2cms[var] < 0) {
+        ext2cms[var] = cms2ext.size();
+        cms2ext.push_back(var);
+    }
+    return ext2cms[var];
+}
+
+// CMS 需要手動增加變數數量：新配置的編號以 new_vars 一次加入
+void SATSolver::syncVars() {
+    unsigned n = solver->nVars();
+    if (cms2ext.size() > n) solver->new_vars(cms2ext.size() - n);
 }
 
 void SATSolver::addClause(const std::vector<int>& clause) {
-    // 同步更新你原本代碼中檢查用的 clauses vector
-    clauses.push_back(clause);
+    num_clauses++;
+    if (small) {
+        small->addClause(clause);
+        if (small->numVars() > small_vars) switchToCMS();
+        return;
+    }
+    addCMSClause(clause);
+}
 
-    std::vector<CMSat::Lit> cms_lits;
+void SATSolver::addCMSClause(const std::vector<int>& clause) {
+    cms_lits.clear();
     for (int lit : clause) {
-        int var = std::abs(lit) - 1; // 轉為 0-indexed
-        ensure_vars(var);
         // CMSat::Lit(變數編號, 是否為負)
-        cms_lits.push_back(CMSat::Lit(var, lit < 0));
+        cms_lits.push_back(CMSat::Lit(cmsVar(std::abs(lit)), lit < 0));
+    }
+    syncVars();
+    solver->add_clause(cms_lits);
+}
+
+void SATSolver::addXorClause(const std::vector<int>& vars, bool rhs) {
+    num_clauses++;
+    if (small) switchToCMS();
+
+    std::vector<unsigned> cms_vars;
+    for (int v : vars) cms_vars.push_back(cmsVar(v));
+    syncVars();
+    solver->add_xor_clause(cms_vars, rhs);
+}
+
+void SATSolver::enableGauss() {
+    if (small) switchToCMS();
+    solver->set_allow_otf_gauss();
+}
+
+void SATSolver::setPolarity(bool polarity) {
+    config.polarity = polarity ? 1 : 0;
+    if (small) {
+        small->setPolarity(polarity);
+        return;
+    }
+    solver->set_default_polarity(polarity);
+}
+
+void SATSolver::setMaxTime(double seconds) {
+    if (std::isinf(seconds)) {
+        time_limit = std::chrono::steady_clock::time_point::max();
+    } else {
+        time_limit = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(0.0, seconds)));
     }
-    solver.add_clause(cms_lits);
+    if (small) {
+        small->setMaxTime(seconds);
+        return;
+    }
+    if (std::isinf(seconds)) {
+        solver->set_max_time(std::numeric_limits<double>::max());
+        return;
+    }
+    solver->set_max_time(std::max(0.0, seconds));
+}
+
+void SATSolver::setMaxConflicts(long long conflicts) {
+    conflict_limit = conflicts < 0 ? -1 : conflicts;
+    if (small) {
+        small->setMaxConflicts(conflicts < 0 ? -1 : conflicts);
+        return;
+    }
+    // CMS 的上限從目前的 conflict 數起算，最大值 (溢位時) 即為不限制
+    solver->set_max_confl(conflicts < 0 ? std::numeric_limits<uint64_t>::max() : (uint64_t)conflicts);
 }
 
 SATResult SATSolver::solve(std::map<int, bool>& assignment, const std::vector<int>& vars_of_interest) {
-    CMSat::lbool res = solver.solve();
+    return solve(assignment, vars_of_interest, std::vector<int>());
+}
+
+CMSat::lbool SATSolver::solve_cms(const std::vector<int>& assumptions) {
+    cms_lits.clear();
+    for (int lit : assumptions) {
+        cms_lits.push_back(CMSat::Lit(cmsVar(std::abs(lit)), lit < 0));
+    }
+    syncVars();
+    return solver->solve(&cms_lits);
+}
+
+SATResult SATSolver::solve(std::vector<bool>& model, const std::vector<int>& assumptions) {
+    if (small) {
+        // 只出現在 assumption 裡的變數不會經過 addClause，在這裡也檢查門檻
+        small->addVars(assumptions);
+        if (small->numVars() <= small_vars) return small->solve(model, assumptions);
+        switchToCMS();
+    }
+    CMSat::lbool res = solve_cms(assumptions);
 
     if (res == CMSat::l_True) {
-        assignment.clear();
-        const std::vector<CMSat::lbool> model = solver.get_model();
-        
-        for (int v : vars_of_interest) {
-            int var_idx = std::abs(v) - 1;
-            if (var_idx < (int)model.size()) {
-                // 如果 CMS 返回 l_True 代表真，l_False 代表假
-                assignment[v] = (model[var_idx] == CMSat::l_True);
-            } else {
-                assignment[v] = false; // 沒出現過的變數預設給 false
-            }
+        // CMS 的模型以壓縮後的編號索引，換回外部編號。
+        // 先全部設為 false：沒有對應到 CMS 變數的位置 (例如換到 CMS 之前由 SmallSAT 寫入的) 不能留下舊的值
+        const std::vector<CMSat::lbool>& cms_model = solver->get_model();
+        if ((int)model.size() < max_var + 1) model.resize(max_var + 1);
+        std::fill(model.begin(), model.end(), false);
+        for (size_t v = 0; v < cms_model.size() && v < cms2ext.size(); v++) {
+            model[cms2ext[v]] = (cms_model[v] == CMSat::l_True);
         }
         return S_SAT;
     } else if (res == CMSat::l_False) {
         return S_UNSAT;
     }
     return S_UNKNOWN;
-}
\ No newline at end of file
+}
+
+void SATSolver::failedAssumptions(std::vector<int>& failed) {
+    if (small) {
+        small->failedAssumptions(failed);
+        return;
+    }
+    failed.clear();
+    for (const CMSat::Lit& lit : solver->get_conflict()) {
+        // get_conflict 回傳的是 assumption 的否定
+        int var = cms2ext[lit.var()];
+        failed.push_back(lit.sign() ? var : -var);
+    }
+}
+
+SATResult SATSolver::solve(std::map<int, bool>& assignment, const std::vector<int>& vars_of_interest, const std::vector<int>& assumptions) {
+    std::vector<bool> model;
+    SATResult res = solve(model, assumptions);
+
+    if (res == S_SAT) {
+        assignment.clear();
+        for (int v : vars_of_interest) {
+            int var = std::abs(v);
+            // 沒出現過的變數預設給 false
+            assignment[v] = (var < (int)model.size()) ? (bool)model[var] : false;
+        }
+    }
+    return res;
+}
@@ -1,29 +1,98 @@
 #ifndef SAT_H
 #define SAT_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <map>
 #include <cryptominisat.h>
 
 enum SATResult { S_SAT, S_UNSAT, S_UNKNOWN };
 
+// CMS 的 restart 策略 (SolverConf::restartType)；R_DEFAULT 為 CMS 的預設
+enum SATRestart { R_DEFAULT, R_GLUE, R_GEOMETRIC, R_LUBY };
+
+// 建立 CMS 時以 SolverConf 交給它的搜尋設定 (portfolio 的每個成員使用不同的值)。
+// SmallSAT 沒有隨機選擇，只使用 polarity
+struct SATConfig {
+    unsigned seed = 0;          // SolverConf::origSeed
+    int polarity = -1;          // -1 不設定，0 為 false，1 為 true
+    SATRestart restart = R_DEFAULT;
+};
+
+class SmallSAT;
+
+// SAT 求解介面，背後有兩個引擎：
+//   - SmallSAT (small_sat.h)：內建的小型 CDCL，建立成本幾乎為零
+//   - CryptoMiniSat
+// small_vars > 0 時先使用 SmallSAT，用到的變數超過 small_vars 個或需要 XOR / Gauss 時，
+// 把原始子句交給新建立的 CMS，之後都由 CMS 求解 (只換一次)。small_vars 為 0 時一開始就使用 CMS。
 class SATSolver {
 public:
-    SATSolver();
+    // interrupt 不為 nullptr 時，SAT 引擎會在搜尋中檢查這個旗標；
+    // 旗標被設為 true 後，求解中與之後的 solve 都會回傳 S_UNKNOWN
+    explicit SATSolver(std::atomic<bool>* interrupt = nullptr, int small_vars = 0, const SATConfig& config = SATConfig());
     ~SATSolver();
 
     // 依照你原本的呼叫方式：addClause(std::vector<int>)
     void addClause(const std::vector<int>& clause);
 
+    // 原生 XOR 限制：vars (正的變數編號) 的 XOR 等於 rhs，交給 CMS 的 Gauss-Jordan 消去處理
+    void addXorClause(const std::vector<int>& vars, bool rhs);
+
+    // 開啟 CMS 的 Gauss-Jordan elimination (預設關閉)
+    void enableGauss();
+
+    // 決策時變數優先嘗試的值 (CMS 的 default polarity)，與 SATConfig::polarity 相同但可以在建立後設定
+    void setPolarity(bool polarity);
+
+    // 下一次 solve 的上限 (CMS 的 set_max_time / set_max_confl，從呼叫時起算)；
+    // 超過時 solve 回傳 S_UNKNOWN。上限會一直保留到下次設定：seconds 為 infinity、conflicts 為負時不限制
+    void setMaxTime(double seconds);
+    void setMaxConflicts(long long conflicts);
+
     // 依照你原本的呼叫方式：solve(map, vector<int>)
     SATResult solve(std::map<int, bool>& assignment, const std::vector<int>& vars_of_interest);
 
-    // 為了相容你 code 中的 sat.clauses.empty() 判斷
-    std::vector<std::vector<int>> clauses; 
+    // 在假設 (assumptions) 之下求解；assumptions 為一般整數文字，求解結束後不會留下
+    SATResult solve(std::map<int, bool>& assignment, const std::vector<int>& vars_of_interest, const std::vector<int>& assumptions);
+
+    // 熱迴圈用：把整個模型寫進呼叫端持有的 model，model[v] 為變數 v 的值 (以變數編號索引)。
+    // model 只會在變數數量增加時變大，不會每次重新配置。
+    SATResult solve(std::vector<bool>& model, const std::vector<int>& assumptions);
+
+    // 上一次 solve 為 UNSAT 時，導致矛盾的 assumptions (CMS get_conflict 取反)。
+    // 結果是傳入 assumptions 的子集合；與 assumptions 無關的 UNSAT 會得到空集合。
+    void failedAssumptions(std::vector<int>& failed);
+
+    // 已加入的子句數 (子句本身只存在 SAT 引擎內部，不另外複製一份)
+    size_t numClauses() const { return num_clauses; }
+
+    // 目前是否由 SmallSAT 求解
+    bool usingSmall() const { return small != nullptr; }
 
 private:
-    CMSat::SATSolver solver;
-    void ensure_vars(int max_var_id);
+    std::atomic<bool>* interrupt;
+    int small_vars;
+    SATConfig config; // 換到 CMS 時以此建立 SolverConf (polarity 含 setPolarity 的值)
+    // setMaxTime / setMaxConflicts 的值，換到 CMS 時重新設定 (時間換算成剩下的部分)
+    std::chrono::steady_clock::time_point time_limit = std::chrono::steady_clock::time_point::max();
+    long long conflict_limit = -1;
+    std::unique_ptr<SmallSAT> small;
+    std::unique_ptr<CMSat::SATSolver> solver;
+    size_t num_clauses = 0;
+    void startCMS();
+    void switchToCMS();
+    // CMS 只看到用到的變數：外部編號 (可能很大且稀疏，例如選擇變數) 壓縮成 0..k-1
+    std::vector<int> ext2cms;       // 以外部變數編號索引，未出現為 -1
+    std::vector<int> cms2ext;
+    int max_var = 0;                // 出現過的最大外部編號 (模型的大小)
+    std::vector<CMSat::Lit> cms_lits; // 子句與 assumption 轉換的暫存
+    unsigned cmsVar(int var);
+    void syncVars();
+    void addCMSClause(const std::vector<int>& clause);
+    CMSat::lbool solve_cms(const std::vector<int>& assumptions);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include "small_sat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// Luby 數列 (1 1 2 1 1 2 4 ...)：第 i 次 restart 前允許的 conflict 數的倍數
+long long luby(long long i) {
+    long long size = 1, seq = 0;
+    while (size < i + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    long long x = i;
+    while (size - 1 != x) {
+        size = (size - 1) >> 1;
+        seq--;
+        x = x % size;
+    }
+    return 1LL << seq;
+}
+
+} // namespace
+
+void SmallSAT::setMaxTime(double seconds) {
+    if (std::isinf(seconds)) {
+        deadline = std::chrono::steady_clock::time_point::max();
+        return;
+    }
+    auto limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(0.0, seconds)));
+    deadline = std::chrono::steady_clock::now() + limit;
+}
+
+// 外部文字 -> 內部文字，第一次出現的變數在這裡配置
+int SmallSAT::internalLit(int lit) {
+    int ext = std::abs(lit);
+    if (ext >= (int)ext2int.size()) ext2int.resize(ext + 1, -1);
+    if (ext2int[ext] < 0) {
+        int v = int2ext.size();
+        ext2int[ext] = v;
+        int2ext.push_back(ext);
+        vals.push_back(0);
+        vals.push_back(0);
+        level.push_back(0);
+        reason.push_back(-1);
+        activity.push_back(0);
+        phase.push_back(default_polarity);
+        seen.push_back(0);
+        watches.emplace_back();
+        watches.emplace_back();
+    }
+    max_ext = std::max(max_ext, ext);
+    return 2 * ext2int[ext] + (lit < 0);
+}
+
+void SmallSAT::addVars(const std::vector<int>& lits) {
+    for (int lit : lits) internalLit(lit);
+}
+
+void SmallSAT::addClause(const std::vector<int>& clause) {
+    // 1. 轉成內部文字、排序去重；tautology 與第 0 層已滿足的子句不必加入，已為假的文字刪掉
+    scratch.clear();
+    for (int lit : clause) scratch.push_back(internalLit(lit));
+    // 上一次 solve 中斷時，第 0 層可能還有沒傳播完的單位文字
+    if (ok && qhead < trail.size() && propagate() >= 0) ok = false;
+    if (!ok) return;
+    std::sort(scratch.begin(), scratch.end());
+    scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+    size_t j = 0;
+    for (size_t i = 0; i < scratch.size(); i++) {
+        int lit = scratch[i];
+        if (vals[lit] == 1 || (i + 1 < scratch.size() && scratch[i + 1] == (lit ^ 1))) return;
+        if (vals[lit] == 0) scratch[j++] = lit;
+    }
+    scratch.resize(j);
+
+    // 2. 空子句與單位子句直接在第 0 層處理
+    if (scratch.empty()) {
+        ok = false;
+        return;
+    }
+    if (scratch.size() == 1) {
+        enqueue(scratch[0], -1);
+        if (propagate() >= 0) ok = false;
+        return;
+    }
+    addToArena(scratch, false);
+}
+
+int SmallSAT::addToArena(const std::vector<int>& lits, bool is_learnt) {
+    int ref = arena.size();
+    arena.push_back(lits.size());
+    arena.push_back(is_learnt);
+    arena.insert(arena.end(), lits.begin(), lits.end());
+    watches[lits[0]].push_back(ref);
+    watches[lits[1]].push_back(ref);
+    if (is_learnt) learnts.push_back(ref);
+    return ref;
+}
+
+void SmallSAT::enqueue(int lit, int from) {
+    vals[lit] = 1;
+    vals[lit ^ 1] = -1;
+    level[lit >> 1] = decisionLevel();
+    reason[lit >> 1] = from;
+    trail.push_back(lit);
+}
+
+// 回傳衝突子句的位置，沒有衝突為 -1
+int SmallSAT::propagate() {
+    while (qhead < trail.size()) {
+        int false_lit = trail[qhead++] ^ 1;
+        std::vector<int>& ws = watches[false_lit];
+        size_t i = 0, j = 0;
+        while (i < ws.size()) {
+            int ref = ws[i++];
+            int size = arena[ref];
+            int* c = &arena[ref + 2];
+            if (c[0] == false_lit) std::swap(c[0], c[1]);
+            if (vals[c[0]] == 1) {
+                ws[j++] = ref;
+                continue;
+            }
+            // 找新的 watch 文字
+            bool moved = false;
+            for (int k = 2; k < size; k++) {
+                if (vals[c[k]] != -1) {
+                    std::swap(c[1], c[k]);
+                    watches[c[1]].push_back(ref);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+            ws[j++] = ref;
+            if (vals[c[0]] == -1) {
+                while (i < ws.size()) ws[j++] = ws[i++];
+                ws.resize(j);
+                qhead = trail.size();
+                return ref;
+            }
+            enqueue(c[0], ref);
+        }
+        ws.resize(j);
+    }
+    return -1;
+}
+
+void SmallSAT::bumpVar(int v) {
+    activity[v] += var_inc;
+    if (activity[v] > 1e100) {
+        for (double& a : activity) a *= 1e-100;
+        var_inc *= 1e-100;
+    }
+}
+
+// 1UIP：學習子句寫進 learnt (learnt[0] 為 UIP 的否定，learnt[1] 為回溯層的文字)
+void SmallSAT::analyze(int confl, int& bt_level) {
+    learnt.clear();
+    learnt.push_back(-1);
+    int path = 0;
+    int p = -1;
+    int index = trail.size() - 1;
+    do {
+        int size = arena[confl];
+        const int* c = &arena[confl + 2];
+        for (int k = (p == -1) ? 0 : 1; k < size; k++) {
+            int q = c[k];
+            int v = q >> 1;
+            if (seen[v] || level[v] == 0) continue;
+            seen[v] = 1;
+            bumpVar(v);
+            if (level[v] >= decisionLevel()) path++;
+            else learnt.push_back(q);
+        }
+        while (!seen[trail[index] >> 1]) index--;
+        p = trail[index--];
+        confl = reason[p >> 1];
+        seen[p >> 1] = 0;
+        path--;
+    } while (path > 0);
+    learnt[0] = p ^ 1;
+
+    bt_level = 0;
+    for (size_t k = 1; k < learnt.size(); k++) {
+        seen[learnt[k] >> 1] = 0;
+        if (level[learnt[k] >> 1] > bt_level) {
+            bt_level = level[learnt[k] >> 1];
+            std::swap(learnt[1], learnt[k]);
+        }
+    }
+    var_inc /= 0.95;
+}
+
+// assumption p 為假：找出使它為假的 assumption (含 p 本身)
+void SmallSAT::analyzeFinal(int p) {
+    failed_assumptions.clear();
+    failed_assumptions.push_back(externalLit(p));
+    if (decisionLevel() == 0) return;
+    seen[p >> 1] = 1;
+    for (int i = (int)trail.size() - 1; i >= trail_lim[0]; i--) {
+        int v = trail[i] >> 1;
+        if (!seen[v]) continue;
+        if (reason[v] < 0) {
+            // 這些層的決策都是 assumption
+            failed_assumptions.push_back(externalLit(trail[i]));
+        } else {
+            int size = arena[reason[v]];
+            const int* c = &arena[reason[v] + 2];
+            for (int k = 1; k < size; k++) {
+                if (level[c[k] >> 1] > 0) seen[c[k] >> 1] = 1;
+            }
+        }
+        seen[v] = 0;
+    }
+    seen[p >> 1] = 0;
+}
+
+void SmallSAT::cancelUntil(int target) {
+    if (decisionLevel() <= target) return;
+    for (int i = (int)trail.size() - 1; i >= trail_lim[target]; i--) {
+        int lit = trail[i];
+        vals[lit] = 0;
+        vals[lit ^ 1] = 0;
+        phase[lit >> 1] = !(lit & 1);
+    }
+    trail.resize(trail_lim[target]);
+    trail_lim.resize(target);
+    qhead = trail.size();
+}
+
+// 在第 0 層丟掉一半較長的學習子句，並重建 watch (第 0 層不需要 reason)。
+// 重建時順便用第 0 層的值化簡：已滿足的子句丟掉，已為假的文字刪掉，watch 才不會落在假的文字上
+void SmallSAT::reduceLearnts() {
+    // keep 與 old 是成員暫存：整理完後 old 保留舊 arena 的容量，下次整理時直接當成新的 arena
+    std::vector<int>& keep = reduce_keep;
+    keep.assign(learnts.begin(), learnts.end());
+    std::sort(keep.begin(), keep.end(), [&](int a, int b) { return arena[a] < arena[b]; });
+    keep.resize(keep.size() / 2);
+    std::sort(keep.begin(), keep.end());
+
+    std::vector<int>& old = reduce_old;
+    old.clear();
+    old.swap(arena);
+    learnts.clear();
+    for (auto& ws : watches) ws.clear();
+    for (int v = 0; v < (int)reason.size(); v++) reason[v] = -1;
+    size_t next_keep = 0;
+    for (size_t ref = 0; ref < old.size(); ref += 2 + old[ref]) {
+        bool is_learnt = old[ref + 1];
+        if (is_learnt) {
+            while (next_keep < keep.size() && keep[next_keep] < (int)ref) next_keep++;
+            if (next_keep >= keep.size() || keep[next_keep] != (int)ref) continue;
+        }
+        learnt.clear();
+        bool satisfied = false;
+        for (int k = 0; k < old[ref]; k++) {
+            int lit = old[ref + 2 + k];
+            if (vals[lit] == 1) satisfied = true;
+            if (vals[lit] == 0) learnt.push_back(lit);
+        }
+        // 第 0 層已傳播完，沒被滿足的子句至少還有兩個未賦值的文字
+        if (satisfied) continue;
+        addToArena(learnt, is_learnt);
+    }
+    max_learnts += max_learnts / 10;
+}
+
+bool SmallSAT::outOfBudget(long long conflicts) {
+    if (max_conflicts >= 0 && conflicts >= max_conflicts) return true;
+    if (conflicts % 64 != 0) return false;
+    if (interrupt != nullptr && interrupt->load(std::memory_order_relaxed)) return true;
+    return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+}
+
+SATResult SmallSAT::solve(std::vector<bool>& model, const std::vector<int>& assumptions) {
+    failed_assumptions.clear();
+    assumps.clear();
+    for (int lit : assumptions) assumps.push_back(internalLit(lit));
+    if (!ok) return S_UNSAT;
+    if (interrupt != nullptr && interrupt->load(std::memory_order_relaxed)) return S_UNKNOWN;
+
+    long long conflicts = 0;
+    long long restarts = 0;
+    long long restart_limit = 100 * luby(0);
+    long long since_restart = 0;
+    while (true) {
+        int confl = propagate();
+        if (confl >= 0) {
+            // 1. 衝突：學習並回溯
+            conflicts++;
+            since_restart++;
+            if (decisionLevel() == 0) {
+                ok = false;
+                return S_UNSAT;
+            }
+            int bt_level;
+            analyze(confl, bt_level);
+            cancelUntil(bt_level);
+            if (learnt.size() == 1) {
+                enqueue(learnt[0], -1);
+            } else {
+                enqueue(learnt[0], addToArena(learnt, true));
+            }
+            if (outOfBudget(conflicts)) {
+                cancelUntil(0);
+                return S_UNKNOWN;
+            }
+            continue;
+        }
+
+        // 2. restart，並在第 0 層整理學習子句
+        if (since_restart >= restart_limit) {
+            cancelUntil(0);
+            since_restart = 0;
+            restart_limit = 100 * luby(++restarts);
+            if ((int)learnts.size() > max_learnts) reduceLearnts();
+            continue;
+        }
+
+        // 3. 決策：先依序放 assumption，再選 activity 最高的未賦值變數
+        int next = -1;
+        while (decisionLevel() < (int)assumps.size()) {
+            int p = assumps[decisionLevel()];
+            if (vals[p] == 1) {
+                trail_lim.push_back(trail.size());
+            } else if (vals[p] == -1) {
+                analyzeFinal(p);
+                cancelUntil(0);
+                return S_UNSAT;
+            } else {
+                next = p;
+                break;
+            }
+        }
+        if (next < 0) {
+            int best = -1;
+            for (int v = 0; v < (int)int2ext.size(); v++) {
+                if (vals[2 * v] == 0 && (best < 0 || activity[v] > activity[best])) best = v;
+            }
+            if (best < 0) {
+                // 所有變數都有值：寫出模型
+                if ((int)model.size() < max_ext + 1) model.resize(max_ext + 1);
+                for (int v = 0; v < (int)int2ext.size(); v++) model[int2ext[v]] = (vals[2 * v] == 1);
+                cancelUntil(0);
+                return S_SAT;
+            }
+            next = 2 * best + (phase[best] ? 0 : 1);
+        }
+        trail_lim.push_back(trail.size());
+        enqueue(next, -1);
+    }
+}
+
+void SmallSAT::originalClauses(std::vector<int>& lits) const {
+    lits.clear();
+    if (!ok) {
+        lits.push_back(0);
+        return;
+    }
+    for (int lit : trail) {
+        lits.push_back(externalLit(lit));
+        lits.push_back(0);
+    }
+    for (size_t ref = 0; ref < arena.size(); ref += 2 + arena[ref]) {
+        if (arena[ref + 1]) continue;
+        for (int k = 0; k < arena[ref]; k++) lits.push_back(externalLit(arena[ref + 2 + k]));
+        lits.push_back(0);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef SMALL_SAT_H
+#define SMALL_SAT_H
+
+#include "sat.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// 小型 CDCL 引擎 (legacy/old_sat.cpp 回溯法的後繼)：給只有幾十個變數的抽象使用，
+// 省下建立 CMS 的成本。SATSolver 在變數數量不超過門檻時使用它 (見 sat.h)。
+//
+//   - 兩個 watch 文字的 unit propagation、1UIP 學習、VSIDS (線性掃描選變數)、phase saving、Luby restart
+//   - 在 assumption 下求解；UNSAT 時取出導致矛盾的 assumption (與 CMS 的 get_conflict 相同的子集合)
+//   - 外部變數編號第一次出現時對應到連續的內部編號：選擇變數的編號很大、實際用到的變數很少也沒關係
+//   - 陣列只在變數或子句增加時變大，求解中不配置記憶體 (學習子句的整理也重複使用暫存)
+class SmallSAT {
+public:
+    explicit SmallSAT(std::atomic<bool>* interrupt = nullptr) : interrupt(interrupt) {}
+
+    // 只能在兩次 solve 之間呼叫 (此時一定在第 0 層)
+    void addClause(const std::vector<int>& clause);
+
+    // 先為 lits 的變數配置內部編號 (solve 前用來得知 assumption 會讓變數數量變成多少)
+    void addVars(const std::vector<int>& lits);
+
+    // 與 SATSolver::solve 相同：model[v] 為變數 v 的值，沒出現過的變數為 false
+    SATResult solve(std::vector<bool>& model, const std::vector<int>& assumptions);
+    void failedAssumptions(std::vector<int>& failed) const { failed = failed_assumptions; }
+
+    void setPolarity(bool polarity) { default_polarity = polarity; }
+    void setMaxTime(double seconds);                   // infinity：不限制
+    void setMaxConflicts(long long conflicts) { max_conflicts = conflicts; } // 負數：不限制
+
+    int numVars() const { return (int)int2ext.size(); }
+    int maxVar() const { return max_ext; }
+
+    // 換到 CMS 時使用：所有原始子句 (外部文字，以 0 結尾) 與第 0 層的單位文字
+    void originalClauses(std::vector<int>& lits) const;
+
+private:
+    std::atomic<bool>* interrupt;
+    bool ok = true; // false：沒有 assumption 也 UNSAT
+    bool default_polarity = false;
+    long long max_conflicts = -1;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // 內部變數 v 的文字為 2v (正) 與 2v + 1 (負)
+    std::vector<int> ext2int; // 以外部變數編號索引，未出現為 -1
+    std::vector<int> int2ext;
+    int max_ext = 0;
+
+    std::vector<signed char> vals;  // 以文字索引：1 為真，-1 為假，0 未賦值
+    std::vector<int> level;
+    std::vector<int> reason;        // 推出此變數的子句 (arena 中的位置)，決策為 -1
+    std::vector<double> activity;
+    std::vector<char> phase;
+    std::vector<char> seen;
+    std::vector<std::vector<int>> watches; // watches[l]：l 是前兩個文字之一的子句，l 變成假時檢查
+
+    // 子句存在一個連續的陣列中：[長度, 是否為學習子句, 文字...]
+    std::vector<int> arena;
+    std::vector<int> learnts;
+    int max_learnts = 2000;
+
+    std::vector<int> trail;
+    std::vector<int> trail_lim;
+    size_t qhead = 0;
+    double var_inc = 1;
+
+    // 求解中重複使用的暫存
+    std::vector<int> assumps;
+    std::vector<int> learnt;
+    std::vector<int> failed_assumptions;
+    std::vector<int> scratch;
+    std::vector<int> reduce_keep; // reduceLearnts 的暫存
+    std::vector<int> reduce_old;
+
+    int internalLit(int lit);
+    int externalLit(int lit) const { return (lit & 1) ? -int2ext[lit >> 1] : int2ext[lit >> 1]; }
+    int decisionLevel() const { return trail_lim.size(); }
+    void enqueue(int lit, int from);
+    int propagate();
+    void analyze(int confl, int& bt_level);
+    void analyzeFinal(int p);
+    void cancelUntil(int target);
+    int addToArena(const std::vector<int>& lits, bool is_learnt);
+    void bumpVar(int v);
+    void reduceLearnts();
+    bool outOfBudget(long long conflicts);
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "log.h"
+#include "qbf.h"
+#include "xor_finder.h"
+#include <algorithm>
+#include <cstdlib>
+
+// 2QBF 引擎：正規化後只有兩個量詞區塊 X (外層，第 0 層) 與 Y (內層，第 1 層)。
+// 兩個 SAT solver 在整個求解過程中常駐，每一輪只加入子句：
+//   candidate : 外層玩家的候選賦值
+//   verifier  : 內層玩家對候選賦值的反例
+// 反例 y 代入 matrix 後得到的限制 (expansion) 直接加進 candidate，不需要逐層遞迴。
+// 子句 i 的「X 部分」/「Y 部分」為它在外層 / 內層的文字。
+QBFResult QBFSolver::solve2QBF(const std::vector<Formula>& prefix, const ClauseDB& matrix, int max_ID) {
+    LOG_INFO("2qbf : " << prefix[0].quantifier << prefix[1].quantifier);
+    for (const auto& clause : matrix) {
+        if (clause.empty()) return Q_UNSAT;
+    }
+    if (prefix[0].quantifier == 'e') return solve2QBFExistsForall(matrix, max_ID);
+    return solve2QBFForallExists(matrix, max_ID);
+}
+
+// ∃X ∀Y：
+//   verifier 的變數為 Y 與 f_i (f_i -> 子句 i 的 Y 部分全為假)，並要求至少一個 f_i 為真。
+//   X 部分已被候選 x 滿足的子句以 assumption -f_i 排除；verifier UNSAT 代表 x 對所有 y 成立。
+//   反例 y 讓某些子句的 Y 部分為假，這些子句的 X 部分就必須由 X 滿足，直接加進 candidate。
+//   每一輪至少加入一個新的子句，最多 m 輪。
+QBFResult QBFSolver::solve2QBFExistsForall(const ClauseDB& matrix, int max_ID) {
+    int number_of_clauses = matrix.size();
+    SATSolver candidate(&interrupt_state->cms, options.small_sat_vars, satConfig());
+    SATSolver verifier(&interrupt_state->cms, options.small_sat_vars, satConfig());
+    LevelStats& ls_x = st.levels[0];
+    LevelStats& ls_y = st.levels[1];
+
+    // 1. 只有 X 文字的子句一定要由 X 滿足；其餘子句交給 verifier
+    std::vector<char> in_candidate(number_of_clauses, 0);
+    std::vector<int> x_part, any_falsified;
+    for (int i = 0; i < number_of_clauses; i++) {
+        int f = max_ID + 1 + i;
+        x_part.clear();
+        bool has_y = false;
+        for (int lit : matrix[i]) {
+            if (levelOf(std::abs(lit)) == 1) {
+                verifier.addClause({-f, -lit});
+                has_y = true;
+            } else {
+                x_part.push_back(lit);
+            }
+        }
+        if (has_y) {
+            any_falsified.push_back(f);
+        } else {
+            candidate.addClause(x_part);
+            in_candidate[i] = 1;
+        }
+    }
+    if (options.use_xor) add2QBFXors(candidate, matrix, 0);
+
+    std::vector<bool> x_model(max_ID + number_of_clauses + 2, false);
+    std::vector<bool> y_model(max_ID + number_of_clauses + 2, false);
+    if (any_falsified.empty()) {
+        // 沒有 ∀ 文字：只剩 X 上的 SAT 問題
+        SATResult res = timedSolve(candidate, x_model, {}, ls_x);
+        if (res == S_UNKNOWN) return Q_UNKNOWN;
+        return (res == S_SAT) ? Q_SAT : Q_UNSAT;
+    }
+    verifier.addClause(any_falsified);
+    ls_x.peak_clauses = candidate.numClauses();
+    ls_y.peak_clauses = verifier.numClauses();
+
+    std::vector<int> assumptions;
+    while (true) {
+        // 2. 外層的候選賦值
+        ls_x.iterations++;
+        SATResult res = timedSolve(candidate, x_model, {}, ls_x);
+        if (res == S_UNKNOWN) return Q_UNKNOWN;
+        if (res == S_UNSAT) return Q_UNSAT;
+
+        // 3. 找反例：只有 X 部分未被 x 滿足的子句可以被 ∀ 弄成假
+        assumptions.clear();
+        for (int i = 0; i < number_of_clauses; i++) {
+            bool satisfied = in_candidate[i];
+            for (int j = 0; !satisfied && j < (int)matrix[i].size(); j++) {
+                int lit = matrix[i][j];
+                if (levelOf(std::abs(lit)) != 1 && x_model[std::abs(lit)] == (lit > 0)) satisfied = true;
+            }
+            if (satisfied) assumptions.push_back(-(max_ID + 1 + i));
+        }
+        ls_y.iterations++;
+        res = timedSolve(verifier, y_model, assumptions, ls_y);
+        if (res == S_UNKNOWN) return Q_UNKNOWN;
+        if (res == S_UNSAT) return Q_SAT;
+
+        // 4. Expansion：y 讓 Y 部分為假的子句，X 部分必須成立
+        int added = 0;
+        for (int i = 0; i < number_of_clauses; i++) {
+            if (in_candidate[i]) continue;
+            bool y_satisfied = false;
+            x_part.clear();
+            for (int lit : matrix[i]) {
+                if (levelOf(std::abs(lit)) == 1) {
+                    if (y_model[std::abs(lit)] == (lit > 0)) y_satisfied = true;
+                } else {
+                    x_part.push_back(lit);
+                }
+            }
+            if (y_satisfied) continue;
+            candidate.addClause(x_part);
+            in_candidate[i] = 1;
+            added++;
+            ls_x.refinement_literals += x_part.size();
+            ls_x.max_refinement_size = std::max(ls_x.max_refinement_size, (int)x_part.size());
+        }
+        ls_x.refinements += added;
+        ls_x.peak_clauses = candidate.numClauses();
+        LOG_DEBUG("2qbf ea iter=" << ls_x.iterations << " added=" << added);
+    }
+}
+
+// ∀X ∃Y：
+//   verifier 含有整個 matrix，以候選 x 作為 assumption 求解 Y；UNSAT 代表 ∀ 找到反例。
+//   candidate 的變數為 X 與 t_i (t_i -> 子句 i 的 X 部分全為假)。
+//   verifier 找到 y 時，下一個 x 必須讓某個 Y 部分未被 y 滿足的子句的 X 部分全為假，
+//   細化子句為這些 t_i 的 OR；沒有這種子句時 y 對所有 x 都成立，candidate 變成 UNSAT。
+QBFResult QBFSolver::solve2QBFForallExists(const ClauseDB& matrix, int max_ID) {
+    int number_of_clauses = matrix.size();
+    SATSolver candidate(&interrupt_state->cms, options.small_sat_vars, satConfig());
+    SATSolver verifier(&interrupt_state->cms, options.small_sat_vars, satConfig());
+    LevelStats& ls_x = st.levels[0];
+    LevelStats& ls_y = st.levels[1];
+
+    std::vector<int> x_vars;
+    std::vector<char> is_x(max_ID + 1, 0);
+    for (const auto& clause : matrix) {
+        std::vector<int> lits(clause.begin(), clause.end());
+        verifier.addClause(lits);
+        for (int lit : clause) {
+            int var = std::abs(lit);
+            if (levelOf(var) != 0 || is_x[var]) continue;
+            is_x[var] = 1;
+            x_vars.push_back(var);
+        }
+    }
+    for (int i = 0; i < number_of_clauses; i++) {
+        int t = max_ID + 1 + i;
+        for (int lit : matrix[i]) {
+            if (is_x[std::abs(lit)]) candidate.addClause({-t, -lit});
+        }
+    }
+    if (options.use_xor) add2QBFXors(verifier, matrix, 1);
+    ls_x.peak_clauses = candidate.numClauses();
+    ls_y.peak_clauses = verifier.numClauses();
+
+    std::vector<bool> x_model(max_ID + number_of_clauses + 2, false);
+    std::vector<bool> y_model(max_ID + number_of_clauses + 2, false);
+    std::vector<int> assumptions, refinement;
+    while (true) {
+        // 1. ∀ 的候選賦值
+        ls_x.iterations++;
+        SATResult res = timedSolve(candidate, x_model, {}, ls_x);
+        if (res == S_UNKNOWN) return Q_UNKNOWN;
+        if (res == S_UNSAT) return Q_SAT;
+
+        // 2. 固定 x，∃ 能否滿足整個 matrix
+        assumptions.clear();
+        for (int var : x_vars) assumptions.push_back(x_model[var] ? var : -var);
+        ls_y.iterations++;
+        res = timedSolve(verifier, y_model, assumptions, ls_y);
+        if (res == S_UNKNOWN) return Q_UNKNOWN;
+        if (res == S_UNSAT) return Q_UNSAT;
+
+        // 3. 細化：y 沒有照顧到的子句中，至少一個的 X 部分要全為假
+        refinement.clear();
+        for (int i = 0; i < number_of_clauses; i++) {
+            bool y_satisfied = false;
+            for (int lit : matrix[i]) {
+                int var = std::abs(lit);
+                if (!is_x[var] && y_model[var] == (lit > 0)) {
+                    y_satisfied = true;
+                    break;
+                }
+            }
+            if (!y_satisfied) refinement.push_back(max_ID + 1 + i);
+        }
+        candidate.addClause(refinement);
+        ls_x.refinements++;
+        ls_x.refinement_literals += refinement.size();
+        ls_x.max_refinement_size = std::max(ls_x.max_refinement_size, (int)refinement.size());
+        ls_x.peak_clauses = candidate.numClauses();
+        LOG_DEBUG("2qbf ae iter=" << ls_x.iterations << " refinement=" << (int)refinement.size());
+    }
+}
+
+// XOR 的變數全部屬於第 depth 層 (必須是 ∃ 區塊) 時，以原生 XOR 交給 solver
+void QBFSolver::add2QBFXors(SATSolver& solver, const ClauseDB& matrix, int depth) {
+    std::vector<XorConstraint> xors = findXors(matrix, options.max_xor_size);
+    int placed = 0;
+    for (const XorConstraint& x : xors) {
+        bool same_level = true;
+        for (int var : x.vars) {
+            if (levelOf(var) != depth || quantifierOf(var) != 'e') same_level = false;
+        }
+        if (!same_level) continue;
+        if (options.gauss && placed == 0) solver.enableGauss();
+        solver.addXorClause(x.vars, x.rhs);
+        placed++;
+    }
+    LOG_INFO("xor found :" << (int)xors.size() << " placed :" << placed);
+}
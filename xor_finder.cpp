@@ -0,0 +1,89 @@
+#include "xor_finder.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+// 一個可能屬於 XOR 的子句：變數排序後的符號遮罩 (bit j = 第 j 個變數為負文字)
+struct Candidate {
+    uint64_t hash;
+    size_t clause;
+    uint32_t mask;
+};
+
+} // namespace
+
+std::vector<XorConstraint> findXors(const ClauseDB& matrix, int max_size) {
+    std::vector<XorConstraint> xors;
+    max_size = std::min(max_size, 6); // 2^(k-1) 個子句，遮罩放得進 64 bits
+
+    // 1. 收集長度合適、沒有重複變數的子句
+    std::vector<Candidate> cands;
+    std::vector<int> lits;
+    for (size_t i = 0; i < matrix.size(); i++) {
+        ClauseDB::Clause clause = matrix[i];
+        if (clause.size() < 2 || (int)clause.size() > max_size) continue;
+        lits.assign(clause.begin(), clause.end());
+        std::sort(lits.begin(), lits.end(), [](int a, int b) { return std::abs(a) < std::abs(b); });
+        bool ok = true;
+        uint64_t hash = 1469598103934665603ull;
+        uint32_t mask = 0;
+        for (size_t j = 0; j < lits.size(); j++) {
+            if (j > 0 && std::abs(lits[j]) == std::abs(lits[j - 1])) {
+                ok = false;
+                break;
+            }
+            hash = (hash ^ (uint64_t)std::abs(lits[j])) * 1099511628211ull;
+            if (lits[j] < 0) mask |= 1u << j;
+        }
+        if (ok) cands.push_back({hash, i, mask});
+    }
+
+    // 2. 依變數集合分組 (先比 hash，再比實際的變數)
+    auto sameVars = [&](size_t a, size_t b) {
+        ClauseDB::Clause ca = matrix[a], cb = matrix[b];
+        if (ca.size() != cb.size()) return false;
+        std::vector<int> va, vb;
+        for (int lit : ca) va.push_back(std::abs(lit));
+        for (int lit : cb) vb.push_back(std::abs(lit));
+        std::sort(va.begin(), va.end());
+        std::sort(vb.begin(), vb.end());
+        return va == vb;
+    };
+    std::sort(cands.begin(), cands.end(), [](const Candidate& a, const Candidate& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.clause < b.clause;
+    });
+
+    std::vector<bool> used(cands.size(), false);
+    for (size_t start = 0; start < cands.size(); start++) {
+        if (used[start]) continue;
+        size_t k = matrix[cands[start].clause].size();
+        size_t needed = (size_t)1 << (k - 1);
+
+        // 同 hash 的一段中，挑出真正與 start 變數相同的子句
+        uint64_t seen[2] = {0, 0};
+        std::vector<size_t> members[2];
+        for (size_t j = start; j < cands.size() && cands[j].hash == cands[start].hash; j++) {
+            if (used[j] || !sameVars(cands[start].clause, cands[j].clause)) continue;
+            used[j] = true;
+            uint32_t mask = cands[j].mask;
+            int parity = __builtin_popcount(mask) & 1;
+            if (seen[parity] & (1ull << mask)) continue; // 重複子句
+            seen[parity] |= 1ull << mask;
+            members[parity].push_back(cands[j].clause);
+        }
+
+        // 3. 負文字個數為 parity 的組合全部出現 -> XOR = !parity
+        for (int parity = 0; parity < 2; parity++) {
+            if (members[parity].size() != needed) continue;
+            XorConstraint x;
+            for (int lit : matrix[cands[start].clause]) x.vars.push_back(std::abs(lit));
+            std::sort(x.vars.begin(), x.vars.end());
+            x.rhs = (parity == 0);
+            x.clauses = members[parity];
+            xors.push_back(std::move(x));
+        }
+    }
+    return xors;
+}
@@ -0,0 +1,19 @@
+#ifndef XOR_FINDER_H
+#define XOR_FINDER_H
+
+#include "clause_db.h"
+#include <vector>
+
+// 由 CNF 子句群還原出來的 XOR 限制：vars 的 XOR 等於 rhs
+struct XorConstraint {
+    std::vector<int> vars;        // 依變數編號排序
+    bool rhs;
+    std::vector<size_t> clauses;  // 構成這個 XOR 的 2^(k-1) 個子句在 matrix 中的編號
+};
+
+// 找出 matrix 中所有以完整 CNF 編碼的 XOR (長度 2 .. max_size)。
+// 同一組變數上，若負文字個數同奇偶的 2^(k-1) 種符號組合全部出現，
+// 這些子句就恰好等價於一個 XOR。
+std::vector<XorConstraint> findXors(const ClauseDB& matrix, int max_size);
+
+#endif